@@ -1,29 +1,58 @@
 #include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
 #include<math.h>
+#include<pthread.h>
+#include<unistd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include<immintrin.h>
+#define HAVE_X86_SIMD 1
+#endif
+
+/* Scalar and vector paths must round identically, so no fused multiply-add */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
 
 /* Constants for mathematical calculations and precision */
 #define PI 3.14159265358979323846
 #define EPSILON 1e-9
 
-int main ()
-{
-    double x1, y1, r1;
-    double x2, y2, r2;
-    double dx, dy, d, overlap;
+/* Size of the input/output blocks used by the batch mode */
+#define BATCH_BUF_SIZE (1 << 20)
 
-    /* Input handling for Circle #1 */
-    printf("Enter circle #1 parameters:\n");
-    if (scanf("%lf %lf %lf", &x1, &y1, &r1)!= 3 || r1 <= 0) {
-        printf("Invalid input.\n");
-        return 0;
-    }
+/* Number of circle pairs classified together by the vector kernels */
+#define PAIR_BLOCK 1024
 
-    /* Input handling for Circle #2 */
-    printf("Enter circle #2 parameters:\n");
-    if (scanf("%lf %lf %lf", &x2, &y2, &r2)!= 3 || r2 <= 0) {
-        printf("Invalid input.\n");
-        return 0;
-    }
+/* Circles handed to an all-pairs worker at a time */
+#define GRID_CHUNK 1024
+
+/* Bounds of the grid levels and cell coordinates (far outliers are clamped) */
+#define GRID_MAX_LEVEL 2100
+#define GRID_COORD_MAX 1e15
+
+/* Relative position of two circles, numbered in the order the cases are tested */
+enum {
+    CASE_IDENTICAL = 1,
+    CASE_DISJOINT,
+    CASE_EXTERNAL_TOUCH,
+    CASE_C2_INSIDE_C1,
+    CASE_C1_INSIDE_C2,
+    CASE_INTERNAL_TOUCH,
+    CASE_INTERSECT
+};
+
+/**
+ * Classifies the relative position of two circles and computes their overlap.
+ * Returns one of the CASE_* codes, the overlap area is stored to *overlap.
+ */
+static int classify(double x1, double y1, double r1,
+                    double x2, double y2, double r2, double *overlap)
+{
+    double dx, dy, d;
 
     /* Calculate Euclidean distance between the two centers */
     dx = x2 - x1;
@@ -34,60 +63,1358 @@ int main ()
     double scale = fmax(r1, r2);
     double relative_epsilon = EPSILON * scale;
 
+    *overlap = 0;
+
     /* Case 1: Identical Circles */
     if (fabs(d) < relative_epsilon && fabs(r1 - r2) < relative_epsilon){
-        overlap = PI * r1 * r1;
-        printf("The circles are identical, overlap: %lf\n", overlap);
-        return 0;
+        *overlap = PI * r1 * r1;
+        return CASE_IDENTICAL;
     }
 
     /* Case 2: Circles are far apart (Disjoint) */
-    if (d > r1 + r2 + relative_epsilon) {
-        printf("The circles lie outside each other, no overlap.\n");
-        return 0;
-    }
+    if (d > r1 + r2 + relative_epsilon)
+        return CASE_DISJOINT;
 
     /* Case 3: External Touch */
-    if (fabs(d - (r1 + r2)) < relative_epsilon) {
-        printf("External touch, no overlap.\n");
-        return 0;
-    }
+    if (fabs(d - (r1 + r2)) < relative_epsilon)
+        return CASE_EXTERNAL_TOUCH;
 
     /* Case 4: Circle 2 is fully inside Circle 1 */
     if (d + r2 < r1 - relative_epsilon) {
-        overlap = PI * r2 * r2;
-        printf("Circle #2 lies inside circle #1, overlap: %lf\n", overlap);
-        return 0;
+        *overlap = PI * r2 * r2;
+        return CASE_C2_INSIDE_C1;
     }
 
     /* Case 5: Circle 1 is fully inside Circle 2 */
     if (d + r1 < r2 - relative_epsilon) {
-        overlap = PI * r1 * r1;
-      printf("Circle #1 lies inside circle #2, overlap: %lf\n", overlap);
-        return 0;
+        *overlap = PI * r1 * r1;
+        return CASE_C1_INSIDE_C2;
     }
 
     /* Case 6: Internal Touch */
     if(fabs(d - fabs(r1 - r2)) < relative_epsilon){
         double smaller = (r1 < r2) ? r1 : r2;
-        overlap = PI * smaller * smaller;
-        if (r1 > r2)
-            printf("Internal touch, circle #2 lies inside circle #1, overlap: %lf\n",overlap);
-        else
-            printf("Internal touch, circle #1 lies inside circle #2, overlap: %lf\n",overlap);
-        return 0;
+        *overlap = PI * smaller * smaller;
+        return CASE_INTERNAL_TOUCH;
     }
 
-    /* Case 7: Circles Intersect 
+    /* Case 7: Circles Intersect
        Calculating the area of overlap using the circular segment formula */
     {
         double case1, case2, case3;
         case1 = (r1 * r1) * acos((d * d + r1 * r1 - r2 * r2) / (2 * d * r1));
         case2 = (r2 * r2) * acos((d * d + r2 * r2 - r1 * r1) / (2 * d * r2));
         case3 = 0.5 * sqrt((-d + r1 + r2) * (d + r1 - r2) * (d - r1 + r2) * (d + r1 + r2));
-        overlap = case1 + case2 - case3;
+        *overlap = case1 + case2 - case3;
+    }
+    return CASE_INTERSECT;
+}
+
+/* -------------------- VECTOR KERNEL -------------------- */
+
+/* Structure-of-arrays block of circle pairs */
+typedef struct {
+    double x1[PAIR_BLOCK], y1[PAIR_BLOCK], r1[PAIR_BLOCK];
+    double x2[PAIR_BLOCK], y2[PAIR_BLOCK], r2[PAIR_BLOCK];
+} PairBlock;
+
+/* Classifies pairs [from, n) of a block, writing case codes and overlaps */
+typedef void (*PairKernel)(const PairBlock *b, size_t from, size_t n, int *code, double *overlap);
+
+static void classify_block_scalar(const PairBlock *b, size_t from, size_t n, int *code, double *overlap)
+{
+    for (size_t i = from; i < n; i++)
+        code[i] = classify(b->x1[i], b->y1[i], b->r1[i], b->x2[i], b->y2[i], b->r2[i], &overlap[i]);
+}
+
+/**
+ * Overlap of the intersecting lanes. The acos arguments and the triangle term
+ * are evaluated in vector registers, acos itself comes from libm per lane so
+ * the result is the same as in classify().
+ */
+static void finish_intersections(const double *r1, const double *r2, const double *arg1,
+                                 const double *arg2, const double *tri, int lanes,
+                                 const int *code, double *overlap)
+{
+    for (int k = 0; k < lanes; k++)
+        if (code[k] == CASE_INTERSECT)
+            overlap[k] = (r1[k] * r1[k]) * acos(arg1[k]) + (r2[k] * r2[k]) * acos(arg2[k]) - tri[k];
+}
+
+#ifdef HAVE_X86_SIMD
+/*
+ * The case cascade is evaluated without branches: every condition becomes a
+ * lane mask and the codes are blended from the last case to the first, so the
+ * earliest matching case wins exactly like in classify().
+ */
+__attribute__((target("avx2")))
+static void classify_block_avx2(const PairBlock *b, size_t from, size_t n, int *code, double *overlap)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d eps = _mm256_set1_pd(EPSILON), pi = _mm256_set1_pd(PI);
+    const __m256d two = _mm256_set1_pd(2.0), half = _mm256_set1_pd(0.5), zero = _mm256_setzero_pd();
+    size_t i = from;
+
+    for (; i + 4 <= n; i += 4) {
+        __m256d x1 = _mm256_loadu_pd(b->x1 + i), y1 = _mm256_loadu_pd(b->y1 + i), r1 = _mm256_loadu_pd(b->r1 + i);
+        __m256d x2 = _mm256_loadu_pd(b->x2 + i), y2 = _mm256_loadu_pd(b->y2 + i), r2 = _mm256_loadu_pd(b->r2 + i);
+        __m256d dx = _mm256_sub_pd(x2, x1), dy = _mm256_sub_pd(y2, y1);
+        __m256d d = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+        __m256d re = _mm256_mul_pd(eps, _mm256_max_pd(r1, r2));
+        __m256d sum = _mm256_add_pd(r1, r2), diff = _mm256_sub_pd(r1, r2);
+        __m256d adiff = _mm256_andnot_pd(sign, diff);
+        __m256d rr1 = _mm256_mul_pd(r1, r1), rr2 = _mm256_mul_pd(r2, r2), dd = _mm256_mul_pd(d, d);
+
+        __m256d m1 = _mm256_and_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign, d), re, _CMP_LT_OQ),
+                                   _mm256_cmp_pd(adiff, re, _CMP_LT_OQ));
+        __m256d m2 = _mm256_cmp_pd(d, _mm256_add_pd(sum, re), _CMP_GT_OQ);
+        __m256d m3 = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(d, sum)), re, _CMP_LT_OQ);
+        __m256d m4 = _mm256_cmp_pd(_mm256_add_pd(d, r2), _mm256_sub_pd(r1, re), _CMP_LT_OQ);
+        __m256d m5 = _mm256_cmp_pd(_mm256_add_pd(d, r1), _mm256_sub_pd(r2, re), _CMP_LT_OQ);
+        __m256d m6 = _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(d, adiff)), re, _CMP_LT_OQ);
+
+        __m256d c = _mm256_set1_pd(CASE_INTERSECT);
+        c = _mm256_blendv_pd(c, _mm256_set1_pd(CASE_INTERNAL_TOUCH), m6);
+        c = _mm256_blendv_pd(c, _mm256_set1_pd(CASE_C1_INSIDE_C2), m5);
+        c = _mm256_blendv_pd(c, _mm256_set1_pd(CASE_C2_INSIDE_C1), m4);
+        c = _mm256_blendv_pd(c, _mm256_set1_pd(CASE_EXTERNAL_TOUCH), m3);
+        c = _mm256_blendv_pd(c, _mm256_set1_pd(CASE_DISJOINT), m2);
+        c = _mm256_blendv_pd(c, _mm256_set1_pd(CASE_IDENTICAL), m1);
+
+        __m256d area1 = _mm256_mul_pd(_mm256_mul_pd(pi, r1), r1);
+        __m256d area2 = _mm256_mul_pd(_mm256_mul_pd(pi, r2), r2);
+        __m256d small = _mm256_min_pd(r1, r2);
+        __m256d a = zero;
+        a = _mm256_blendv_pd(a, _mm256_mul_pd(_mm256_mul_pd(pi, small), small), m6);
+        a = _mm256_blendv_pd(a, area1, m5);
+        a = _mm256_blendv_pd(a, area2, m4);
+        a = _mm256_blendv_pd(a, zero, _mm256_or_pd(m2, m3));
+        a = _mm256_blendv_pd(a, area1, m1);
+
+        __m256d arg1 = _mm256_div_pd(_mm256_sub_pd(_mm256_add_pd(dd, rr1), rr2), _mm256_mul_pd(_mm256_mul_pd(two, d), r1));
+        __m256d arg2 = _mm256_div_pd(_mm256_sub_pd(_mm256_add_pd(dd, rr2), rr1), _mm256_mul_pd(_mm256_mul_pd(two, d), r2));
+        __m256d f1 = _mm256_add_pd(_mm256_sub_pd(r1, d), r2), f2 = _mm256_sub_pd(_mm256_add_pd(d, r1), r2);
+        __m256d f3 = _mm256_add_pd(_mm256_sub_pd(d, r1), r2), f4 = _mm256_add_pd(_mm256_add_pd(d, r1), r2);
+        __m256d prod = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(f1, f2), f3), f4);
+        __m256d tri = _mm256_mul_pd(half, _mm256_sqrt_pd(prod));
+
+        double a1[4], a2[4], t[4];
+        _mm_storeu_si128((__m128i*)(code + i), _mm256_cvtpd_epi32(c));
+        _mm256_storeu_pd(overlap + i, a);
+        if (_mm256_movemask_pd(_mm256_or_pd(_mm256_or_pd(_mm256_or_pd(m1, m2), _mm256_or_pd(m3, m4)),
+                                            _mm256_or_pd(m5, m6))) != 0xF) {
+            _mm256_storeu_pd(a1, arg1);
+            _mm256_storeu_pd(a2, arg2);
+            _mm256_storeu_pd(t, tri);
+            finish_intersections(b->r1 + i, b->r2 + i, a1, a2, t, 4, code + i, overlap + i);
+        }
+    }
+    classify_block_scalar(b, i, n, code, overlap);
+}
+
+__attribute__((target("avx512f")))
+static void classify_block_avx512(const PairBlock *b, size_t from, size_t n, int *code, double *overlap)
+{
+    const __m512d eps = _mm512_set1_pd(EPSILON), pi = _mm512_set1_pd(PI);
+    const __m512d two = _mm512_set1_pd(2.0), half = _mm512_set1_pd(0.5), zero = _mm512_setzero_pd();
+    size_t i = from;
+
+    for (; i + 8 <= n; i += 8) {
+        __m512d x1 = _mm512_loadu_pd(b->x1 + i), y1 = _mm512_loadu_pd(b->y1 + i), r1 = _mm512_loadu_pd(b->r1 + i);
+        __m512d x2 = _mm512_loadu_pd(b->x2 + i), y2 = _mm512_loadu_pd(b->y2 + i), r2 = _mm512_loadu_pd(b->r2 + i);
+        __m512d dx = _mm512_sub_pd(x2, x1), dy = _mm512_sub_pd(y2, y1);
+        __m512d d = _mm512_sqrt_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)));
+        __m512d re = _mm512_mul_pd(eps, _mm512_max_pd(r1, r2));
+        __m512d sum = _mm512_add_pd(r1, r2), diff = _mm512_sub_pd(r1, r2);
+        __m512d adiff = _mm512_abs_pd(diff);
+        __m512d rr1 = _mm512_mul_pd(r1, r1), rr2 = _mm512_mul_pd(r2, r2), dd = _mm512_mul_pd(d, d);
+
+        __mmask8 m1 = _mm512_cmp_pd_mask(_mm512_abs_pd(d), re, _CMP_LT_OQ)
+                    & _mm512_cmp_pd_mask(adiff, re, _CMP_LT_OQ);
+        __mmask8 m2 = _mm512_cmp_pd_mask(d, _mm512_add_pd(sum, re), _CMP_GT_OQ);
+        __mmask8 m3 = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(d, sum)), re, _CMP_LT_OQ);
+        __mmask8 m4 = _mm512_cmp_pd_mask(_mm512_add_pd(d, r2), _mm512_sub_pd(r1, re), _CMP_LT_OQ);
+        __mmask8 m5 = _mm512_cmp_pd_mask(_mm512_add_pd(d, r1), _mm512_sub_pd(r2, re), _CMP_LT_OQ);
+        __mmask8 m6 = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(d, adiff)), re, _CMP_LT_OQ);
+
+        __m512d c = _mm512_set1_pd(CASE_INTERSECT);
+        c = _mm512_mask_blend_pd(m6, c, _mm512_set1_pd(CASE_INTERNAL_TOUCH));
+        c = _mm512_mask_blend_pd(m5, c, _mm512_set1_pd(CASE_C1_INSIDE_C2));
+        c = _mm512_mask_blend_pd(m4, c, _mm512_set1_pd(CASE_C2_INSIDE_C1));
+        c = _mm512_mask_blend_pd(m3, c, _mm512_set1_pd(CASE_EXTERNAL_TOUCH));
+        c = _mm512_mask_blend_pd(m2, c, _mm512_set1_pd(CASE_DISJOINT));
+        c = _mm512_mask_blend_pd(m1, c, _mm512_set1_pd(CASE_IDENTICAL));
+
+        __m512d area1 = _mm512_mul_pd(_mm512_mul_pd(pi, r1), r1);
+        __m512d area2 = _mm512_mul_pd(_mm512_mul_pd(pi, r2), r2);
+        __m512d small = _mm512_min_pd(r1, r2);
+        __m512d a = zero;
+        a = _mm512_mask_blend_pd(m6, a, _mm512_mul_pd(_mm512_mul_pd(pi, small), small));
+        a = _mm512_mask_blend_pd(m5, a, area1);
+        a = _mm512_mask_blend_pd(m4, a, area2);
+        a = _mm512_mask_blend_pd(m2 | m3, a, zero);
+        a = _mm512_mask_blend_pd(m1, a, area1);
+
+        __m512d arg1 = _mm512_div_pd(_mm512_sub_pd(_mm512_add_pd(dd, rr1), rr2), _mm512_mul_pd(_mm512_mul_pd(two, d), r1));
+        __m512d arg2 = _mm512_div_pd(_mm512_sub_pd(_mm512_add_pd(dd, rr2), rr1), _mm512_mul_pd(_mm512_mul_pd(two, d), r2));
+        __m512d f1 = _mm512_add_pd(_mm512_sub_pd(r1, d), r2), f2 = _mm512_sub_pd(_mm512_add_pd(d, r1), r2);
+        __m512d f3 = _mm512_add_pd(_mm512_sub_pd(d, r1), r2), f4 = _mm512_add_pd(_mm512_add_pd(d, r1), r2);
+        __m512d prod = _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(f1, f2), f3), f4);
+        __m512d tri = _mm512_mul_pd(half, _mm512_sqrt_pd(prod));
+
+        double a1[8], a2[8], t[8];
+        _mm256_storeu_si256((__m256i*)(code + i), _mm512_cvtpd_epi32(c));
+        _mm512_storeu_pd(overlap + i, a);
+        if ((__mmask8)(m1 | m2 | m3 | m4 | m5 | m6) != 0xFF) {
+            _mm512_storeu_pd(a1, arg1);
+            _mm512_storeu_pd(a2, arg2);
+            _mm512_storeu_pd(t, tri);
+            finish_intersections(b->r1 + i, b->r2 + i, a1, a2, t, 8, code + i, overlap + i);
+        }
+    }
+    classify_block_scalar(b, i, n, code, overlap);
+}
+#endif /* HAVE_X86_SIMD */
+
+/* Picks the widest kernel the running CPU supports */
+static PairKernel select_kernel(void)
+{
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return classify_block_avx512;
+    if (__builtin_cpu_supports("avx2")) return classify_block_avx2;
+#endif
+    return classify_block_scalar;
+}
+
+/* -------------------- BATCH MODE -------------------- */
+
+/* Block-buffered reader over stdin, the buffer is always NUL terminated */
+typedef struct {
+    char *buf;
+    size_t pos, len;
+    int eof;
+} Reader;
+
+/* Moves the unread tail to the front of the buffer and appends the next block */
+static void reader_fill(Reader *rd)
+{
+    size_t rest = rd->len - rd->pos;
+    memmove(rd->buf, rd->buf + rd->pos, rest);
+    rd->pos = 0;
+    rd->len = rest;
+    if (!rd->eof) {
+        size_t got = fread(rd->buf + rest, 1, BATCH_BUF_SIZE - rest, stdin);
+        if (got == 0) rd->eof = 1;
+        rd->len += got;
+    }
+    rd->buf[rd->len] = '\0';
+}
+
+static int is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* Exact powers of ten, usable without rounding error */
+static const double pow10_exact[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * Converts a plain decimal token ([+-]digits[.digits]).
+ * When the mantissa fits into 53 bits and the power of ten is exact, a single
+ * multiplication/division is correctly rounded, so the result equals strtod.
+ * Everything else (exponents, long mantissas, hex, inf...) goes to strtod.
+ */
+static int parse_double(const char *s, const char *end, double *out)
+{
+    const char *p = s;
+    int neg = 0, digits = 0, frac = 0;
+    unsigned long long mant = 0;
+
+    if (*p == '+' || *p == '-') neg = (*p++ == '-');
+    while (p < end && *p >= '0' && *p <= '9' && digits < 19) {
+        mant = mant * 10 + (unsigned long long)(*p++ - '0');
+        digits++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9' && digits < 19) {
+            mant = mant * 10 + (unsigned long long)(*p++ - '0');
+            digits++;
+            frac++;
+        }
+    }
+    if (p == end && digits > 0 && mant < (1ULL << 53) && frac <= 22) {
+        double v = (double)mant / pow10_exact[frac];
+        *out = neg ? -v : v;
+        return 1;
+    }
+
+    char *endp;
+    *out = strtod(s, &endp);
+    return endp == end && endp != s;
+}
+
+/* Reads the next whitespace separated number. Returns 1 on success, 0 at EOF, -1 on error */
+static int next_double(Reader *rd, double *out)
+{
+    for (;;) {
+        while (rd->pos < rd->len && is_space(rd->buf[rd->pos])) rd->pos++;
+        if (rd->pos < rd->len) break;
+        if (rd->eof) return 0;
+        reader_fill(rd);
+    }
+
+    /* Make sure the whole token is in the buffer before converting it */
+    size_t e = rd->pos;
+    for (;;) {
+        while (e < rd->len && !is_space(rd->buf[e])) e++;
+        if (e < rd->len || rd->eof) break;
+        e -= rd->pos;
+        reader_fill(rd);
+        if (e == rd->len && !rd->eof && rd->len == BATCH_BUF_SIZE) return -1;
+    }
+
+    int ok = parse_double(rd->buf + rd->pos, rd->buf + e, out);
+    rd->pos = e;
+    return ok ? 1 : -1;
+}
+
+/* Output buffer flushed to stdout in large blocks */
+typedef struct {
+    char *buf;
+    size_t len;
+} Writer;
+
+static void writer_flush(Writer *w)
+{
+    fwrite(w->buf, 1, w->len, stdout);
+    w->len = 0;
+}
+
+/* Values with |value| * 1e6 below the limit are formatted by hand; there the
+ * product is off by at most 2^-13, far less than the margin kept from .5 */
+#define FAST_FIXED_LIMIT 1e12
+#define FAST_FIXED_MARGIN 1e-3
+/* Room for one result line: %lf of the largest double has 316 characters */
+#define RESULT_MAX 352
+
+/**
+ * Appends "<code> <overlap>\n" exactly as printf("%d %lf\n") would. The
+ * scaled value is rounded by hand unless its fraction lies within
+ * FAST_FIXED_MARGIN of .5, where the rounding error of the product could
+ * flip the result; those values, huge ones and non-finite ones go through
+ * snprintf.
+ */
+static void write_result(Writer *w, int code, double overlap)
+{
+    if (w->len > BATCH_BUF_SIZE - RESULT_MAX) writer_flush(w);
+    char *p = w->buf + w->len;
+    *p++ = (char)('0' + code);
+    *p++ = ' ';
+
+    double scaled = fabs(overlap) * 1e6;
+    unsigned long long whole = scaled < FAST_FIXED_LIMIT ? (unsigned long long)scaled : 0;
+    double frac = scaled - (double)whole;
+    if (scaled < FAST_FIXED_LIMIT && fabs(frac - 0.5) > FAST_FIXED_MARGIN) {
+        unsigned long long v = whole + (frac > 0.5);
+        unsigned long long ip = v / 1000000, fp = v % 1000000;
+        if (signbit(overlap)) *p++ = '-';
+        char tmp[24];
+        int n = 0;
+        do { tmp[n++] = (char)('0' + ip % 10); ip /= 10; } while (ip);
+        while (n) *p++ = tmp[--n];
+        *p++ = '.';
+        for (int i = 5; i >= 0; i--) { p[i] = (char)('0' + fp % 10); fp /= 10; }
+        p += 6;
+    } else {
+        p += snprintf(p, RESULT_MAX - 4, "%lf", overlap);
+    }
+    *p++ = '\n';
+    w->len = (size_t)(p - w->buf);
+}
+
+/* Classifies the first n pairs of the block and appends their results */
+static void flush_block(PairKernel kernel, const PairBlock *b, size_t n, int *code, double *overlap, Writer *w)
+{
+    kernel(b, 0, n, code, overlap);
+    for (size_t i = 0; i < n; i++)
+        write_result(w, code[i], overlap[i]);
+}
+
+/**
+ * Batch mode: reads records "x1 y1 r1 x2 y2 r2" until EOF and prints
+ * one "<case> <overlap>" line per record (case codes as in CASE_*).
+ * Records are collected into blocks of PAIR_BLOCK pairs for the vector kernel.
+ */
+static int run_batch(void)
+{
+    Reader rd = { (char*)malloc(BATCH_BUF_SIZE + 1), 0, 0, 0 };
+    Writer w = { (char*)malloc(BATCH_BUF_SIZE), 0 };
+    PairBlock *blk = (PairBlock*)malloc(sizeof(PairBlock));
+    int *code = (int*)malloc(PAIR_BLOCK * sizeof(int));
+    double *overlap = (double*)malloc(PAIR_BLOCK * sizeof(double));
+    PairKernel kernel = select_kernel();
+    size_t n = 0;
+    int rc = 0;
+
+    if (!rd.buf || !w.buf || !blk || !code || !overlap) {
+        rc = 1;
+        goto done;
+    }
+    rd.buf[0] = '\0';
+
+    for (;;) {
+        double v[6];
+        int r = next_double(&rd, &v[0]);
+        if (r == 0) break;
+        for (int i = 1; i < 6 && r == 1; i++) r = next_double(&rd, &v[i]);
+        if (r != 1 || v[2] <= 0 || v[5] <= 0) {
+            flush_block(kernel, blk, n, code, overlap, &w);
+            n = 0;
+            writer_flush(&w);
+            printf("Invalid input.\n");
+            break;
+        }
+        blk->x1[n] = v[0]; blk->y1[n] = v[1]; blk->r1[n] = v[2];
+        blk->x2[n] = v[3]; blk->y2[n] = v[4]; blk->r2[n] = v[5];
+        if (++n == PAIR_BLOCK) {
+            flush_block(kernel, blk, n, code, overlap, &w);
+            n = 0;
+        }
+    }
+    flush_block(kernel, blk, n, code, overlap, &w);
+    writer_flush(&w);
+
+done:
+    free(rd.buf);
+    free(w.buf);
+    free(blk);
+    free(code);
+    free(overlap);
+    return rc;
+}
+
+/* -------------------- ALL-PAIRS INDEX -------------------- */
+
+/* Set of circles stored as separate coordinate arrays */
+typedef struct {
+    double *x, *y, *r;
+    size_t n, cap;
+} CircleSet;
+
+/* One overlapping pair (i < j) with its classification */
+typedef struct {
+    size_t i, j;
+    int code;
+    double overlap;
+} CirclePair;
+
+/* Growable list of pairs, one per worker thread */
+typedef struct {
+    CirclePair *items;
+    size_t n, cap;
+} PairList;
+
+/**
+ * Hierarchical grid over the bounding boxes of the circles. The cell edge
+ * of level 0 is twice the median diameter and doubles with every level; a
+ * circle lives on the first level whose cell edge is at least its diameter,
+ * so it touches at most 2 x 2 cells there, however large or far away it is.
+ * Cells are keyed by (level, col, row) in an open-addressing hash table, so
+ * empty space costs nothing. The circles of cell c are idx[start[c] ..
+ * start[c+1]) (CSR layout).
+ */
+typedef struct {
+    long long col, row;
+    int lev;
+    unsigned cell;              /* cell + 1, 0 = empty slot */
+} GridSlot;
+
+typedef struct {
+    double base;                /* cell edge of level 0 */
+    int *level;                 /* level of every circle */
+    int *levels, nlevels;       /* occupied levels, ascending */
+    size_t cells;
+    GridSlot *slots;            /* hash table over the cell keys */
+    size_t mask;
+    size_t *key;                /* slot of every cell */
+    size_t *start, *idx;
+} Grid;
+
+/* Work description for one grid worker; circles are taken from a shared counter */
+typedef struct {
+    const CircleSet *cs;
+    const Grid *g;
+    size_t *next;
+    pthread_mutex_t *lock;
+    PairList out;
+    int failed;
+} GridJob;
+
+static int circles_add(CircleSet *cs, double x, double y, double r)
+{
+    if (cs->n == cs->cap) {
+        size_t nc = cs->cap ? cs->cap * 2 : 1024;
+        double *nx = (double*)realloc(cs->x, nc * sizeof(double));
+        if (!nx) return 0;
+        cs->x = nx;
+        double *ny = (double*)realloc(cs->y, nc * sizeof(double));
+        if (!ny) return 0;
+        cs->y = ny;
+        double *nr = (double*)realloc(cs->r, nc * sizeof(double));
+        if (!nr) return 0;
+        cs->r = nr;
+        cs->cap = nc;
+    }
+    cs->x[cs->n] = x;
+    cs->y[cs->n] = y;
+    cs->r[cs->n] = r;
+    cs->n++;
+    return 1;
+}
+
+static void circles_free(CircleSet *cs)
+{
+    free(cs->x);
+    free(cs->y);
+    free(cs->r);
+}
+
+/* Reads "x y r" triples until EOF. Returns 0 on invalid input or memory error */
+static int read_circles(CircleSet *cs)
+{
+    Reader rd = { (char*)malloc(BATCH_BUF_SIZE + 1), 0, 0, 0 };
+    int ok = rd.buf != NULL;
+    if (ok) rd.buf[0] = '\0';
+
+    while (ok) {
+        double x, y, r;
+        int st = next_double(&rd, &x);
+        if (st == 0) break;
+        if (st != 1 || next_double(&rd, &y) != 1 || next_double(&rd, &r) != 1 || r <= 0)
+            ok = 0;
+        else
+            ok = circles_add(cs, x, y, r);
+    }
+    free(rd.buf);
+    return ok;
+}
+
+static int pairs_add(PairList *L, size_t i, size_t j, int code, double overlap)
+{
+    if (L->n == L->cap) {
+        size_t nc = L->cap ? L->cap * 2 : 256;
+        CirclePair *p = (CirclePair*)realloc(L->items, nc * sizeof(CirclePair));
+        if (!p) return 0;
+        L->items = p;
+        L->cap = nc;
+    }
+    L->items[L->n].i = i;
+    L->items[L->n].j = j;
+    L->items[L->n].code = code;
+    L->items[L->n].overlap = overlap;
+    L->n++;
+    return 1;
+}
+
+/* Cell column/row of a coordinate; NaN and far outliers are clamped */
+static long long grid_coord(double v, double cell)
+{
+    double c = floor(v / cell);
+    if (!(c > -GRID_COORD_MAX)) return (long long)-GRID_COORD_MAX;
+    if (c > GRID_COORD_MAX) return (long long)GRID_COORD_MAX;
+    return (long long)c;
+}
+
+static size_t cell_hash(int lev, long long col, long long row)
+{
+    unsigned long long h = (unsigned long long)col * 0x9E3779B97F4A7C15ULL;
+    h ^= (unsigned long long)row * 0xC2B2AE3D27D4EB4FULL + (unsigned long long)lev;
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+/* Slot of a key: the one holding it, or the empty one where it belongs */
+static size_t grid_slot(const Grid *g, int lev, long long col, long long row)
+{
+    size_t s = cell_hash(lev, col, row) & g->mask;
+    while (g->slots[s].cell &&
+           (g->slots[s].col != col || g->slots[s].row != row || g->slots[s].lev != lev))
+        s = (s + 1) & g->mask;
+    return s;
+}
+
+/* Cell of a key, or (size_t)-1 if the cell is empty */
+static size_t grid_find(const Grid *g, int lev, long long col, long long row)
+{
+    return (size_t)g->slots[grid_slot(g, lev, col, row)].cell - 1;
+}
+
+/* Doubles the hash table, keeping it at most 2/3 full; returns 0 on memory error */
+static int grid_grow(Grid *g)
+{
+    size_t slots = 2 * (g->mask + 1);
+    GridSlot *old = g->slots;
+    GridSlot *ns = (GridSlot*)calloc(slots, sizeof(GridSlot));
+    if (!ns) return 0;
+    g->slots = ns;
+    g->mask = slots - 1;
+    for (size_t c = 0; c < g->cells; c++) {
+        const GridSlot *k = &old[g->key[c]];
+        size_t s = grid_slot(g, k->lev, k->col, k->row);
+        g->slots[s] = *k;
+        g->key[c] = s;
+    }
+    free(old);
+    return 1;
+}
+
+/* Cell of a key, created if missing; (size_t)-1 on memory error */
+static size_t grid_insert(Grid *g, int lev, long long col, long long row)
+{
+    if (3 * (g->cells + 1) > 2 * (g->mask + 1) && !grid_grow(g))
+        return (size_t)-1;
+    size_t s = grid_slot(g, lev, col, row);
+    if (!g->slots[s].cell) {
+        g->slots[s].col = col;
+        g->slots[s].row = row;
+        g->slots[s].lev = lev;
+        g->slots[s].cell = (unsigned)++g->cells;
+        g->key[g->cells - 1] = s;
+    }
+    return g->slots[s].cell - 1;
+}
+
+/* Cell range of circle i's bounding box on a level with the given cell edge */
+static void grid_span(const CircleSet *cs, size_t i, double cell,
+                      long long *c0, long long *c1, long long *r0, long long *r1)
+{
+    *c0 = grid_coord(cs->x[i] - cs->r[i], cell);
+    *c1 = grid_coord(cs->x[i] + cs->r[i], cell);
+    *r0 = grid_coord(cs->y[i] - cs->r[i], cell);
+    *r1 = grid_coord(cs->y[i] + cs->r[i], cell);
+}
+
+/* k-th smallest of v[0..n-1] (v is reordered), expected linear time */
+static double select_kth(double *v, size_t n, size_t k)
+{
+    size_t lo = 0, hi = n - 1;
+    while (lo < hi) {
+        double pivot = v[lo + (hi - lo) / 2];
+        size_t i = lo, j = hi;
+        while (i <= j) {
+            while (v[i] < pivot) i++;
+            while (v[j] > pivot) j--;
+            if (i <= j) {
+                double t = v[i]; v[i] = v[j]; v[j] = t;
+                i++;
+                if (j == 0) break;
+                j--;
+            }
+        }
+        if (k <= j) hi = j;
+        else if (k >= i) lo = i;
+        else break;
+    }
+    return v[k];
+}
+
+static void grid_free(Grid *g)
+{
+    free(g->level);
+    free(g->levels);
+    free(g->slots);
+    free(g->key);
+    free(g->start);
+    free(g->idx);
+}
+
+/* Builds the grid; returns 0 on memory error */
+static int grid_build(Grid *g, const CircleSet *cs)
+{
+    size_t n = cs->n;
+    memset(g, 0, sizeof(*g));
+
+    double *radii = (double*)malloc(n * sizeof(double));
+    g->level = (int*)malloc(n * sizeof(int));
+    unsigned char *used = (unsigned char*)calloc(GRID_MAX_LEVEL + 1, 1);
+    if (!radii || !g->level || !used) {
+        free(radii);
+        free(used);
+        return 0;
+    }
+    memcpy(radii, cs->r, n * sizeof(double));
+    g->base = 4 * select_kth(radii, n, n / 2);
+    free(radii);
+
+    /* Level of every circle and the number of cells they touch */
+    size_t touches = 0;
+    for (size_t i = 0; i < n; i++) {
+        int lev = 0;
+        double cell = g->base;
+        while (cell < 2 * cs->r[i] && lev < GRID_MAX_LEVEL) {
+            cell *= 2;
+            lev++;
+        }
+        g->level[i] = lev;
+        used[lev] = 1;
+        long long c0, c1, r0, r1;
+        grid_span(cs, i, cell, &c0, &c1, &r0, &r1);
+        touches += (size_t)((c1 - c0 + 1) * (r1 - r0 + 1));
+    }
+    g->levels = (int*)malloc((GRID_MAX_LEVEL + 1) * sizeof(int));
+    if (g->levels)
+        for (int lev = 0; lev <= GRID_MAX_LEVEL; lev++)
+            if (used[lev]) g->levels[g->nlevels++] = lev;
+    free(used);
+
+    g->mask = 1023;
+    g->slots = (GridSlot*)calloc(g->mask + 1, sizeof(GridSlot));
+    g->key = (size_t*)malloc((touches ? touches : 1) * sizeof(size_t));
+    g->start = (size_t*)calloc(touches + 1, sizeof(size_t));
+    g->idx = (size_t*)malloc((touches ? touches : 1) * sizeof(size_t));
+    if (!g->levels || !g->slots || !g->key || !g->start || !g->idx)
+        return 0;
+
+    /* Counting pass (remembering each circle's cells), prefix sums, then the fill pass */
+    size_t *touch = (size_t*)malloc((touches ? touches : 1) * sizeof(size_t));
+    if (!touch) return 0;
+    size_t t = 0;
+    for (size_t i = 0; i < n; i++) {
+        long long c0, c1, r0, r1;
+        grid_span(cs, i, ldexp(g->base, g->level[i]), &c0, &c1, &r0, &r1);
+        for (long long r = r0; r <= r1; r++)
+            for (long long c = c0; c <= c1; c++) {
+                touch[t] = grid_insert(g, g->level[i], c, r);
+                if (touch[t] == (size_t)-1) {
+                    free(touch);
+                    return 0;
+                }
+                g->start[touch[t++] + 1]++;
+            }
+    }
+    for (size_t c = 0; c < g->cells; c++)
+        g->start[c + 1] += g->start[c];
+
+    size_t *fill = (size_t*)malloc((g->cells ? g->cells : 1) * sizeof(size_t));
+    if (!fill) {
+        free(touch);
+        return 0;
+    }
+    memcpy(fill, g->start, g->cells * sizeof(size_t));
+    t = 0;
+    for (size_t i = 0; i < n; i++) {
+        long long c0, c1, r0, r1;
+        grid_span(cs, i, ldexp(g->base, g->level[i]), &c0, &c1, &r0, &r1);
+        for (size_t k = (size_t)((c1 - c0 + 1) * (r1 - r0 + 1)); k > 0; k--)
+            g->idx[fill[touch[t++]]++] = i;
+    }
+    free(fill);
+    free(touch);
+    return 1;
+}
+
+/* Classifies a candidate pair (a < b) and records it if the circles overlap */
+static int grid_report(GridJob *job, size_t a, size_t b)
+{
+    const CircleSet *cs = job->cs;
+    double overlap;
+    int code = classify(cs->x[a], cs->y[a], cs->r[a], cs->x[b], cs->y[b], cs->r[b], &overlap);
+    if (code == CASE_DISJOINT || code == CASE_EXTERNAL_TOUCH) return 1;
+    return pairs_add(&job->out, a, b, code, overlap);
+}
+
+/* Do the boxes of i and j meet, with the lower left corner of their intersection in (col, row)? */
+static int grid_owns(const CircleSet *cs, size_t i, size_t j, double cell, long long col, long long row)
+{
+    double lx = fmax(cs->x[i] - cs->r[i], cs->x[j] - cs->r[j]);
+    double ly = fmax(cs->y[i] - cs->r[i], cs->y[j] - cs->r[j]);
+    if (lx > fmin(cs->x[i] + cs->r[i], cs->x[j] + cs->r[j]) ||
+        ly > fmin(cs->y[i] + cs->r[i], cs->y[j] + cs->r[j]))
+        return 0;
+    return grid_coord(lx, cell) == col && grid_coord(ly, cell) == row;
+}
+
+/**
+ * Work items are all cells followed by all circles. A cell tests the pairs
+ * of its own circles (same level); a circle looks up the (at most 2 x 2)
+ * cells its bounding box touches on every coarser occupied level. In both
+ * cases a pair is reported only in the cell holding the lower left corner of
+ * the boxes' intersection, so every pair is reported exactly once.
+ */
+static void *grid_worker(void *arg)
+{
+    GridJob *job = (GridJob*)arg;
+    const CircleSet *cs = job->cs;
+    const Grid *g = job->g;
+    size_t items = g->cells + cs->n;
+    int top = g->levels[g->nlevels - 1];
+
+    for (;;) {
+        pthread_mutex_lock(job->lock);
+        size_t from = *job->next;
+        *job->next = from + GRID_CHUNK < items ? from + GRID_CHUNK : items;
+        pthread_mutex_unlock(job->lock);
+        if (from >= items) break;
+
+        for (size_t it = from; it < from + GRID_CHUNK && it < items; it++) {
+            if (it < g->cells) {
+                size_t c = it;
+                const GridSlot *k = &g->slots[g->key[c]];
+                double cell = ldexp(g->base, k->lev);
+                for (size_t p = g->start[c]; p < g->start[c + 1]; p++)
+                    for (size_t q = p + 1; q < g->start[c + 1]; q++)
+                        if (grid_owns(cs, g->idx[p], g->idx[q], cell, k->col, k->row) &&
+                            !grid_report(job, g->idx[p], g->idx[q])) {
+                            job->failed = 1;
+                            return NULL;
+                        }
+                continue;
+            }
+
+            size_t i = it - g->cells;
+            if (g->level[i] == top) continue;
+            for (int k = 0; k < g->nlevels; k++) {
+                int lev = g->levels[k];
+                if (lev <= g->level[i]) continue;
+                double cell = ldexp(g->base, lev);
+                long long c0, c1, r0, r1;
+                grid_span(cs, i, cell, &c0, &c1, &r0, &r1);
+                for (long long row = r0; row <= r1; row++)
+                    for (long long col = c0; col <= c1; col++) {
+                        size_t c = grid_find(g, lev, col, row);
+                        if (c == (size_t)-1) continue;
+                        for (size_t p = g->start[c]; p < g->start[c + 1]; p++) {
+                            size_t j = g->idx[p];
+                            if (!grid_owns(cs, i, j, cell, col, row)) continue;
+                            if (!grid_report(job, i < j ? i : j, i < j ? j : i)) {
+                                job->failed = 1;
+                                return NULL;
+                            }
+                        }
+                    }
+            }
+        }
+    }
+    return NULL;
+}
+
+static int pair_cmp(const void *a, const void *b)
+{
+    const CirclePair *pa = (const CirclePair*)a;
+    const CirclePair *pb = (const CirclePair*)b;
+    if (pa->i != pb->i) return pa->i < pb->i ? -1 : 1;
+    if (pa->j != pb->j) return pa->j < pb->j ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Finds every pair of circles with a positive overlap (cases 1 and 4-7).
+ * Threads take chunks of circles from a shared counter; the merged result
+ * is sorted by (i, j), so the output does not depend on the thread count.
+ * Returns 0 on memory error.
+ */
+static int find_overlapping_pairs(const CircleSet *cs, int threads, PairList *res)
+{
+    Grid g;
+    res->items = NULL;
+    res->n = res->cap = 0;
+    if (cs->n < 2) return 1;
+    if (!grid_build(&g, cs)) {
+        grid_free(&g);
+        return 0;
+    }
+
+    if (threads < 1) threads = 1;
+    GridJob *jobs = (GridJob*)calloc((size_t)threads, sizeof(GridJob));
+    pthread_t *tid = (pthread_t*)malloc((size_t)threads * sizeof(pthread_t));
+    pthread_mutex_t lock;
+    size_t next = 0;
+    int ok = jobs && tid;
+    if (ok) {
+        pthread_mutex_init(&lock, NULL);
+        for (int t = 0; t < threads; t++) {
+            jobs[t].cs = cs;
+            jobs[t].g = &g;
+            jobs[t].next = &next;
+            jobs[t].lock = &lock;
+        }
+        int started = 0;
+        for (int t = 1; t < threads; t++, started++)
+            if (pthread_create(&tid[t], NULL, grid_worker, &jobs[t]) != 0) break;
+        grid_worker(&jobs[0]);
+        for (int t = 1; t <= started; t++)
+            pthread_join(tid[t], NULL);
+        pthread_mutex_destroy(&lock);
+
+        size_t total = 0;
+        for (int t = 0; t < threads; t++) {
+            ok = ok && !jobs[t].failed;
+            total += jobs[t].out.n;
+        }
+        if (ok && total) {
+            res->items = (CirclePair*)malloc(total * sizeof(CirclePair));
+            ok = res->items != NULL;
+        }
+        if (ok) {
+            for (int t = 0; t < threads; t++) {
+                if (!jobs[t].out.n) continue;
+                memcpy(res->items + res->n, jobs[t].out.items, jobs[t].out.n * sizeof(CirclePair));
+                res->n += jobs[t].out.n;
+            }
+            res->cap = res->n;
+            qsort(res->items, res->n, sizeof(CirclePair), pair_cmp);
+        }
+        for (int t = 0; t < threads; t++)
+            free(jobs[t].out.items);
+    }
+
+    free(jobs);
+    free(tid);
+    grid_free(&g);
+    return ok;
+}
+
+/* Appends an unsigned integer followed by a space */
+static void write_index(Writer *w, size_t v)
+{
+    if (w->len > BATCH_BUF_SIZE - 128) writer_flush(w);
+    char tmp[24];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    while (n) w->buf[w->len++] = tmp[--n];
+    w->buf[w->len++] = ' ';
+}
+
+/* Number of worker threads: explicit argument or all online CPUs */
+static int thread_count(int argc, char *argv[], int pos)
+{
+    if (argc > pos) {
+        int t = atoi(argv[pos]);
+        if (t > 0) return t;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+/**
+ * All-pairs mode: reads circles "x y r" until EOF and prints one
+ * "<i> <j> <case> <overlap>" line for every overlapping pair (0-based
+ * indices in input order, sorted by i then j).
+ */
+static int run_all_pairs(int threads)
+{
+    CircleSet cs = { NULL, NULL, NULL, 0, 0 };
+    PairList pairs;
+
+    if (!read_circles(&cs)) {
+        printf("Invalid input.\n");
+        circles_free(&cs);
+        return 0;
+    }
+    if (!find_overlapping_pairs(&cs, threads, &pairs)) {
+        circles_free(&cs);
+        free(pairs.items);
+        return 1;
+    }
+
+    Writer w = { (char*)malloc(BATCH_BUF_SIZE), 0 };
+    if (w.buf) {
+        for (size_t k = 0; k < pairs.n; k++) {
+            write_index(&w, pairs.items[k].i);
+            write_index(&w, pairs.items[k].j);
+            write_result(&w, pairs.items[k].code, pairs.items[k].overlap);
+        }
+        writer_flush(&w);
+    }
+
+    free(w.buf);
+    free(pairs.items);
+    circles_free(&cs);
+    return w.buf ? 0 : 1;
+}
+
+/* -------------------- UNION AREA -------------------- */
+
+/* Angular interval [lo, hi] of a circle's boundary covered by a neighbour */
+typedef struct {
+    double lo, hi;
+} Arc;
+
+/* Shared state of the union-area workers */
+typedef struct {
+    const CircleSet *cs;
+    const size_t *adj_start, *adj;      /* intersecting neighbours, CSR */
+    const size_t *comp_start, *members; /* circles of each component, CSR */
+    size_t comps, next;
+    double *area;
+    pthread_mutex_t lock;
+    int failed;
+} UnionJob;
+
+static size_t uf_find(size_t *parent, size_t v)
+{
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+static int arc_cmp(const void *a, const void *b)
+{
+    double x = ((const Arc*)a)->lo, y = ((const Arc*)b)->lo;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Green's theorem contribution of the boundary arc from angle t1 to t2:
+ * the circular segment cut off by the chord plus the signed triangle
+ * spanned by the origin and the chord. The centre is given relative to the
+ * component's origin, so the cross products stay small far from (0, 0).
+ */
+static double arc_area(double cx, double cy, double r, double t1, double t2)
+{
+    double delta = t2 - t1;
+    double px1 = cx + r * cos(t1), py1 = cy + r * sin(t1);
+    double px2 = cx + r * cos(t2), py2 = cy + r * sin(t2);
+    double segment = 0.5 * r * r * (delta - sin(delta));
+    return segment + 0.5 * (px1 * py2 - px2 * py1);
+}
+
+/**
+ * Area contributed by circle i: the parts of its boundary not covered by an
+ * intersecting neighbour, measured from the point (ox, oy) of its component.
+ * arcs must hold 2 entries per neighbour.
+ */
+static double circle_boundary_area(const UnionJob *job, size_t i, double ox, double oy, Arc *arcs)
+{
+    const CircleSet *cs = job->cs;
+    double cx = cs->x[i], cy = cs->y[i], r = cs->r[i];
+    size_t n = 0;
+
+    for (size_t k = job->adj_start[i]; k < job->adj_start[i + 1]; k++) {
+        size_t j = job->adj[k];
+        double dx = cs->x[j] - cx, dy = cs->y[j] - cy;
+        double d = sqrt(dx * dx + dy * dy);
+        double c = (r * r + d * d - cs->r[j] * cs->r[j]) / (2 * d * r);
+        double beta = acos(fmax(-1.0, fmin(1.0, c)));
+        double lo = atan2(dy, dx) - beta;
+        if (lo < 0) lo += 2 * PI;
+        double hi = lo + 2 * beta;
+        if (hi > 2 * PI) {
+            arcs[n].lo = lo; arcs[n++].hi = 2 * PI;
+            arcs[n].lo = 0; arcs[n++].hi = hi - 2 * PI;
+        } else {
+            arcs[n].lo = lo; arcs[n++].hi = hi;
+        }
+    }
+    if (n == 0) return PI * r * r;
+
+    cx -= ox;
+    cy -= oy;
+    qsort(arcs, n, sizeof(Arc), arc_cmp);
+    double area = 0, pos = 0;
+    for (size_t k = 0; k < n; k++) {
+        if (arcs[k].lo > pos) area += arc_area(cx, cy, r, pos, arcs[k].lo);
+        if (arcs[k].hi > pos) pos = arcs[k].hi;
+    }
+    if (pos < 2 * PI) area += arc_area(cx, cy, r, pos, 2 * PI);
+    return area;
+}
+
+/* Takes components from the shared counter until none are left */
+static void *union_worker(void *arg)
+{
+    UnionJob *job = (UnionJob*)arg;
+    Arc *arcs = NULL;
+    size_t arcs_cap = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t c = job->next++;
+        int stop = c >= job->comps || job->failed;
+        pthread_mutex_unlock(&job->lock);
+        if (stop) break;
+
+        /* The boundary of a component is closed, so any origin gives its area */
+        size_t first = job->members[job->comp_start[c]];
+        double ox = job->cs->x[first], oy = job->cs->y[first];
+        double area = 0;
+        for (size_t m = job->comp_start[c]; m < job->comp_start[c + 1]; m++) {
+            size_t i = job->members[m];
+            size_t need = 2 * (job->adj_start[i + 1] - job->adj_start[i]) + 1;
+            if (need > arcs_cap) {
+                Arc *na = (Arc*)realloc(arcs, need * sizeof(Arc));
+                if (!na) {
+                    pthread_mutex_lock(&job->lock);
+                    job->failed = 1;
+                    pthread_mutex_unlock(&job->lock);
+                    free(arcs);
+                    return NULL;
+                }
+                arcs = na;
+                arcs_cap = need;
+            }
+            area += circle_boundary_area(job, i, ox, oy, arcs);
+        }
+        job->area[c] = area;
+    }
+    free(arcs);
+    return NULL;
+}
+
+/**
+ * Area of the union of all circles. Circles lying inside another one (or
+ * duplicating it) are dropped first, the rest is split into connected
+ * components of intersecting circles, which are evaluated in parallel.
+ * Component areas are added in a fixed order, so the result does not depend
+ * on the thread count. Returns 0 on memory error.
+ */
+static int union_area(const CircleSet *cs, int threads, double *result)
+{
+    PairList pairs;
+    size_t n = cs->n;
+    *result = 0;
+    if (!find_overlapping_pairs(cs, threads, &pairs)) {
+        free(pairs.items);
+        return 0;
+    }
+
+    unsigned char *hidden = (unsigned char*)calloc(n ? n : 1, 1);
+    size_t *parent = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+    size_t *adj_start = (size_t*)calloc(n + 1, sizeof(size_t));
+    size_t *comp_id = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+    size_t *comp_start = (size_t*)calloc(n + 1, sizeof(size_t));
+    size_t *members = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+    size_t *adj = (size_t*)malloc((2 * pairs.n + 1) * sizeof(size_t));
+    double *area = (double*)malloc((n ? n : 1) * sizeof(double));
+    pthread_t *tid = (pthread_t*)malloc((size_t)(threads > 0 ? threads : 1) * sizeof(pthread_t));
+    int ok = hidden && parent && adj_start && comp_id && comp_start && members && adj && area && tid;
+
+    if (ok) {
+        /* Drop circles covered by another circle */
+        for (size_t k = 0; k < pairs.n; k++) {
+            const CirclePair *p = &pairs.items[k];
+            if (p->code == CASE_IDENTICAL || p->code == CASE_C2_INSIDE_C1)
+                hidden[p->j] = 1;
+            else if (p->code == CASE_C1_INSIDE_C2)
+                hidden[p->i] = 1;
+            else if (p->code == CASE_INTERNAL_TOUCH)
+                hidden[cs->r[p->i] > cs->r[p->j] ? p->j : p->i] = 1;
+        }
+
+        /* Intersecting neighbours and connected components */
+        for (size_t i = 0; i < n; i++) parent[i] = i;
+        for (size_t k = 0; k < pairs.n; k++) {
+            const CirclePair *p = &pairs.items[k];
+            if (p->code != CASE_INTERSECT || hidden[p->i] || hidden[p->j]) continue;
+            adj_start[p->i + 1]++;
+            adj_start[p->j + 1]++;
+            size_t a = uf_find(parent, p->i), b = uf_find(parent, p->j);
+            if (a != b) parent[a > b ? a : b] = a < b ? a : b;
+        }
+        for (size_t i = 0; i < n; i++) adj_start[i + 1] += adj_start[i];
+        size_t *fill = comp_id; /* reused as a cursor before numbering components */
+        memcpy(fill, adj_start, n * sizeof(size_t));
+        for (size_t k = 0; k < pairs.n; k++) {
+            const CirclePair *p = &pairs.items[k];
+            if (p->code != CASE_INTERSECT || hidden[p->i] || hidden[p->j]) continue;
+            adj[fill[p->i]++] = p->j;
+            adj[fill[p->j]++] = p->i;
+        }
+
+        /* Number the components by their smallest circle index */
+        size_t comps = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (hidden[i]) continue;
+            size_t root = uf_find(parent, i);
+            comp_id[i] = root == i ? comps++ : comp_id[root];
+            comp_start[comp_id[i] + 1]++;
+        }
+        for (size_t c = 0; c < comps; c++) comp_start[c + 1] += comp_start[c];
+        size_t *cursor = parent; /* union-find no longer needed */
+        memcpy(cursor, comp_start, comps * sizeof(size_t));
+        for (size_t i = 0; i < n; i++)
+            if (!hidden[i]) members[cursor[comp_id[i]]++] = i;
+
+        UnionJob job;
+        job.cs = cs;
+        job.adj_start = adj_start;
+        job.adj = adj;
+        job.comp_start = comp_start;
+        job.members = members;
+        job.comps = comps;
+        job.next = 0;
+        job.area = area;
+        job.failed = 0;
+        pthread_mutex_init(&job.lock, NULL);
+
+        int started = 0;
+        for (int t = 1; t < threads; t++, started++)
+            if (pthread_create(&tid[t], NULL, union_worker, &job) != 0) break;
+        union_worker(&job);
+        for (int t = 1; t <= started; t++)
+            pthread_join(tid[t], NULL);
+        pthread_mutex_destroy(&job.lock);
+
+        ok = !job.failed;
+        for (size_t c = 0; ok && c < comps; c++)
+            *result += area[c];
+    }
+
+    free(hidden);
+    free(parent);
+    free(adj_start);
+    free(comp_id);
+    free(comp_start);
+    free(members);
+    free(adj);
+    free(area);
+    free(tid);
+    free(pairs.items);
+    return ok;
+}
+
+/* Union mode: reads circles "x y r" until EOF and prints the covered area */
+static int run_union(int threads)
+{
+    CircleSet cs = { NULL, NULL, NULL, 0, 0 };
+    double area;
+
+    if (!read_circles(&cs) || cs.n == 0) {
+        printf("Invalid input.\n");
+        circles_free(&cs);
+        return 0;
+    }
+    if (!union_area(&cs, threads, &area)) {
+        circles_free(&cs);
+        return 1;
+    }
+    printf("Union area: %lf\n", area);
+    circles_free(&cs);
+    return 0;
+}
+
+/* Formats one result with write_result and with printf; 1 if they agree */
+static int self_test_value(Writer *w, int code, double overlap)
+{
+    char ref[RESULT_MAX];
+    w->len = 0;
+    write_result(w, code, overlap);
+    snprintf(ref, sizeof(ref), "%d %lf\n", code, overlap);
+    if (w->len == strlen(ref) && memcmp(w->buf, ref, w->len) == 0) return 1;
+    printf("Mismatch for %.17g: \"%.*s\" vs printf \"%.*s\"\n",
+           overlap, (int)w->len - 1, w->buf, (int)strlen(ref) - 1, ref);
+    return 0;
+}
+
+/**
+ * Self-test (-t): the fast writer used by -b and -n must print exactly what
+ * "%d %lf\n" prints. Covers random magnitudes and signs, values next to a
+ * rounding tie, non-finite values and overlaps of nearly tangent circles,
+ * which may come out slightly negative.
+ */
+static int run_self_test(void)
+{
+    Writer w = { (char*)malloc(BATCH_BUF_SIZE), 0 };
+    if (!w.buf) return 1;
+    unsigned long long state = 88172645463325252ULL;
+    long checked = 0;
+    int ok = 1;
+    static const double fixed[] = { 0.0, -0.0, 123.4567895, -0.476881, 1e-7, -4e-7, 5e-7,
+                                    999999.9999995, 1e6, 1e300, -1e300, HUGE_VAL, -HUGE_VAL, NAN };
+
+    for (size_t i = 0; ok && i < sizeof(fixed) / sizeof(fixed[0]); i++, checked++)
+        ok = self_test_value(&w, 7, fixed[i]);
+    for (long i = 0; ok && i < 3000000; i++) {
+        /* xorshift64: magnitudes 10^-8 .. 10^8, ties (k + 0.5) / 10^6 and their neighbours */
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        double u = (double)(state >> 11) / 9007199254740992.0;
+        double v = pow(10.0, 16 * u - 8);
+        if (i % 3 == 0) {
+            v = (floor(v * 1e6) + 0.5) / 1e6;
+            if (i % 2) v = nextafter(v, (state & 1) ? HUGE_VAL : 0);
+        }
+        if (state & 2) v = -v;
+        ok = self_test_value(&w, 1 + (int)(i % 7), v);
+        checked++;
+    }
+    for (long i = 0; ok && i < 1000000; i++) {
+        /* Circles touching externally, up to rounding */
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        double r1 = 1 + (double)(state >> 44), r2 = 1 + (double)((state >> 24) & 0xfffff);
+        double overlap;
+        int code = classify(0, 0, r1, r1 + r2 + ((double)(state & 0xffff) - 32768) * 1e-10, 0, r2, &overlap);
+        ok = self_test_value(&w, code, overlap);
+        checked++;
+    }
+    if (ok) printf("Self-test passed: %ld values\n", checked);
+    free(w.buf);
+    return ok ? 0 : 1;
+}
+
+int main (int argc, char *argv[])
+{
+    double x1, y1, r1;
+    double x2, y2, r2;
+    double overlap;
+
+    if (argc > 1 && strcmp(argv[1], "-b") == 0)
+        return run_batch();
+    if (argc > 1 && strcmp(argv[1], "-n") == 0)
+        return run_all_pairs(thread_count(argc, argv, 2));
+    if (argc > 1 && strcmp(argv[1], "-u") == 0)
+        return run_union(thread_count(argc, argv, 2));
+    if (argc > 1 && strcmp(argv[1], "-t") == 0)
+        return run_self_test();
+
+    /* Input handling for Circle #1 */
+    printf("Enter circle #1 parameters:\n");
+    if (scanf("%lf %lf %lf", &x1, &y1, &r1)!= 3 || r1 <= 0) {
+        printf("Invalid input.\n");
+        return 0;
+    }
+
+    /* Input handling for Circle #2 */
+    printf("Enter circle #2 parameters:\n");
+    if (scanf("%lf %lf %lf", &x2, &y2, &r2)!= 3 || r2 <= 0) {
+        printf("Invalid input.\n");
+        return 0;
+    }
+
+    switch (classify(x1, y1, r1, x2, y2, r2, &overlap)) {
+        case CASE_IDENTICAL:
+            printf("The circles are identical, overlap: %lf\n", overlap);
+            break;
+        case CASE_DISJOINT:
+            printf("The circles lie outside each other, no overlap.\n");
+            break;
+        case CASE_EXTERNAL_TOUCH:
+            printf("External touch, no overlap.\n");
+            break;
+        case CASE_C2_INSIDE_C1:
+            printf("Circle #2 lies inside circle #1, overlap: %lf\n", overlap);
+            break;
+        case CASE_C1_INSIDE_C2:
+            printf("Circle #1 lies inside circle #2, overlap: %lf\n", overlap);
+            break;
+        case CASE_INTERNAL_TOUCH:
+            if (r1 > r2)
+                printf("Internal touch, circle #2 lies inside circle #1, overlap: %lf\n",overlap);
+            else
+                printf("Internal touch, circle #1 lies inside circle #2, overlap: %lf\n",overlap);
+            break;
+        default:
+            printf("The circles intersect, overlap: %lf\n", overlap);
+            break;
     }
-    printf("The circles intersect, overlap: %lf\n", overlap);
 
     return 0;
 }
@@ -1,8 +1,38 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Size of the output buffer used when listing variants */
+#define OUT_BUF_SIZE (1 << 20)
+
+static char out_buf[OUT_BUF_SIZE];
+static size_t out_len = 0;
+
+/* Writes the buffered output to stdout */
+static void out_flush(void) {
+    fwrite(out_buf, 1, out_len, stdout);
+    out_len = 0;
+}
+
+/* Appends a string to the output buffer */
+static void out_str(const char *s, size_t len) {
+    if (out_len + len > OUT_BUF_SIZE) out_flush();
+    memcpy(out_buf + out_len, s, len);
+    out_len += len;
+}
+
+/* Appends a non-negative number without going through printf */
+static void out_ll(long long v) {
+    char tmp[24];
+    int n = 0;
+    if (out_len + sizeof(tmp) > OUT_BUF_SIZE) out_flush();
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    while (n) out_buf[out_len++] = tmp[--n];
+}
 
 /**
  * Calculates the Greatest Common Divisor.
- * Useful for future optimizations involving Linear Diophantine Equations.
  */
 long long gcd(long long a, long long b) {
     while (b != 0) {
@@ -13,11 +43,456 @@ long long gcd(long long a, long long b) {
     return a;
 }
 
-int main()
+/**
+ * Extended Euclidean algorithm.
+ * Returns gcd(a, b) and stores x, y such that a * x + b * y = gcd(a, b).
+ */
+long long ext_gcd(long long a, long long b, long long *x, long long *y) {
+    long long x0 = 1, y0 = 0, x1 = 0, y1 = 1;
+    while (b != 0) {
+        long long q = a / b, t;
+        t = a - q * b;   a = b;   b = t;
+        t = x0 - q * x1; x0 = x1; x1 = t;
+        t = y0 - q * y1; y0 = y1; y1 = t;
+    }
+    *x = x0;
+    *y = y0;
+    return a;
+}
+
+/**
+ * Computes (a * b) % m for 0 <= a, b < m without overflowing long long.
+ * Uses a 128-bit product where the compiler provides one.
+ */
+long long mulmod(long long a, long long b, long long m) {
+#ifdef __SIZEOF_INT128__
+    return (long long)((unsigned __int128)a * (unsigned __int128)b % (unsigned __int128)m);
+#else
+    unsigned long long res = 0, x = (unsigned long long)a, um = (unsigned long long)m;
+    unsigned long long y = (unsigned long long)b;
+    while (y) {
+        if (y & 1) res = (res >= um - x) ? res - (um - x) : res + x;
+        x = (x >= um - x) ? x - (um - x) : x + x;
+        y >>= 1;
+    }
+    return (long long)res;
+#endif
+}
+
+/**
+ * Counts the non-negative solutions of a * x + b * y = target in O(log) time.
+ * All solutions are x = x0 + k * (b / g), so it is enough to find the smallest
+ * valid x0 and count how many steps of b / g fit before a * x exceeds target.
+ * The smallest x is stored to *first (if not NULL). No intermediate value
+ * exceeds target, so targets up to LLONG_MAX are safe.
+ */
+long long count_variants(long long a, long long b, long long target, long long *first) {
+    long long g = gcd(a, b);
+    if (target % g != 0) return 0;
+    a /= g;
+    b /= g;
+    target /= g;
+
+    /* x0 = target * a^-1 (mod b), the smallest x with (target - a * x) % b == 0 */
+    long long inv, unused;
+    ext_gcd(a % b, b, &inv, &unused);
+    inv %= b;
+    if (inv < 0) inv += b;
+    long long x0 = mulmod(target % b, inv, b);
+
+    if (x0 > target / a) return 0;
+    if (first) *first = x0;
+    return (target - a * x0) / a / b + 1;
+}
+
+/* -------------------- MULTI-TRACK MODE -------------------- */
+
+/* Largest number of different track lengths in the multi-track mode */
+#define MAX_TRACKS 20
+
+/* Arbitrary precision counter: little-endian 32-bit limbs of a fixed width */
+static void big_add(unsigned *dst, const unsigned *src, size_t w) {
+    unsigned long long carry = 0;
+    for (size_t i = 0; i < w; i++) {
+        carry += (unsigned long long)dst[i] + src[i];
+        dst[i] = (unsigned)carry;
+        carry >>= 32;
+    }
+}
+
+/* Prints a counter in decimal by repeated division by 10^9 */
+static void big_print(const unsigned *v, size_t w) {
+    unsigned *tmp = (unsigned*)malloc(w * sizeof(unsigned));
+    unsigned *parts = (unsigned*)malloc((w * 10 / 9 + 2) * sizeof(unsigned));
+    size_t np = 0, top = w;
+    if (!tmp || !parts) {
+        printf("Memory error\n");
+        exit(1);
+    }
+    memcpy(tmp, v, w * sizeof(unsigned));
+    while (top > 0 && tmp[top - 1] == 0) top--;
+    do {
+        unsigned long long rem = 0;
+        for (size_t i = top; i-- > 0; ) {
+            unsigned long long cur = (rem << 32) | tmp[i];
+            tmp[i] = (unsigned)(cur / 1000000000ULL);
+            rem = cur % 1000000000ULL;
+        }
+        parts[np++] = (unsigned)rem;
+        while (top > 0 && tmp[top - 1] == 0) top--;
+    } while (top > 0);
+    printf("%u", parts[np - 1]);
+    while (--np > 0) printf("%09u", parts[np - 1]);
+    free(tmp);
+    free(parts);
+}
+
+/* Adds a 64-bit value to a counter that is wide enough for the result */
+static void big_add_ull(unsigned *dst, unsigned long long v, size_t w) {
+    unsigned long long carry = v;
+    for (size_t i = 0; i < w && carry; i++) {
+        unsigned long long cur = (unsigned long long)dst[i] + (carry & 0xffffffffULL);
+        dst[i] = (unsigned)cur;
+        carry = (carry >> 32) + (cur >> 32);
+    }
+}
+
+/* Largest number of distances left over by the enumerated long lengths */
+#define MAX_RESIDUALS (1 << 20)
+
+static int ll_cmp(const void *a, const void *b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/* Appends target minus every combination of len[i..n-1] that fits */
+static void list_residuals(const long long *len, int n, int i, long long rem,
+                           long long *res, size_t *count) {
+    if (i == n) {
+        res[(*count)++] = rem;
+        return;
+    }
+    for (;;) {
+        list_residuals(len, n, i + 1, rem, res, count);
+        if (rem < len[i]) break;
+        rem -= len[i];
+    }
+}
+
+/**
+ * Counts the combinations of k track lengths summing to target.
+ *
+ * Lengths that fit only a few times into target are enumerated first,
+ * longest first, as long as at most MAX_RESIDUALS leftover distances come
+ * out; a single long piece therefore costs a few loop steps, not memory.
+ * The leftovers are built from the remaining "ring" lengths:
+ *   - with at most two of them, each leftover is counted in closed form;
+ *   - otherwise, with m the smallest ring length, the ways to build a
+ *     leftover t are the ways to build any v <= t, v = t (mod m), from the
+ *     other ring lengths (the gap is filled with pieces of length m). Those
+ *     come from the unbounded knapsack recurrence
+ *     g_j(v) = g_{j-1}(v) + g_j(v - L_j), evaluated for increasing v, which
+ *     only needs the last L_j values of every g_j: one ring buffer per
+ *     length, plus one running sum per residue class mod m.
+ * Memory is the sum of the ring lengths and does not grow with target.
+ * Counts are kept with enough limbs for the product bound of the answer.
+ */
+static void count_multi(const long long *len, int k, long long target) {
+    long long sorted[MAX_TRACKS], lng[MAX_TRACKS], rng[MAX_TRACKS];
+    int nl = 0, nr = 0;
+    memcpy(sorted, len, (size_t)k * sizeof(long long));
+    qsort(sorted, (size_t)k, sizeof(long long), ll_cmp);
+
+    /* Every count is bounded by the number of choices for all but the smallest length */
+    double bits = 2;
+    for (int i = 1; i < k; i++)
+        bits += log2((double)(target / sorted[i]) + 1);
+    size_t w = (size_t)(bits / 32) + 1;
+
+    /* Lengths longer than target can not be used at all */
+    size_t leftovers = 1;
+    for (int i = k - 1; i >= 0; i--) {
+        if (sorted[i] > target) continue;
+        unsigned long long uses = (unsigned long long)(target / sorted[i]) + 1;
+        if (uses <= MAX_RESIDUALS / leftovers) {
+            lng[nl++] = sorted[i];
+            leftovers *= (size_t)uses;
+        } else
+            rng[nr++] = sorted[i];
+    }
+
+    long long *res = (long long*)malloc(leftovers * sizeof(long long));
+    unsigned *ans = (unsigned*)calloc(w, sizeof(unsigned));
+    if (!res || !ans) {
+        printf("Memory error\n");
+        exit(1);
+    }
+    size_t nres = 0;
+    list_residuals(lng, nl, 0, target, res, &nres);
+
+    if (nr <= 2) {
+        for (size_t c = 0; c < nres; c++) {
+            long long t = res[c], cnt;
+            if (nr == 0) cnt = t == 0;
+            else if (nr == 1) cnt = t % rng[0] == 0;
+            else cnt = count_variants(rng[0], rng[1], t, NULL);
+            big_add_ull(ans, (unsigned long long)cnt, w);
+        }
+    } else {
+        /* rng is in decreasing order: the last one plays m, the others get rings */
+        long long m = rng[nr - 1];
+        int no = nr - 1;
+        qsort(res, nres, sizeof(long long), ll_cmp);
+
+        unsigned **ring = (unsigned**)calloc((size_t)no, sizeof(unsigned*));
+        long long *pos = (long long*)calloc((size_t)no, sizeof(long long));
+        unsigned *one = (unsigned*)calloc(w, sizeof(unsigned));
+        unsigned *zero = (unsigned*)calloc(w, sizeof(unsigned));
+        unsigned *acc = (unsigned*)calloc((size_t)m * w, sizeof(unsigned));
+        unsigned char *need = (unsigned char*)calloc((size_t)m, 1);
+        if (!ring || !pos || !one || !zero || !acc || !need) {
+            printf("Memory error\n");
+            exit(1);
+        }
+        for (int j = 0; j < no; j++) {
+            ring[j] = (unsigned*)calloc((size_t)rng[j] * w, sizeof(unsigned));
+            if (!ring[j]) {
+                printf("Memory error\n");
+                exit(1);
+            }
+        }
+        one[0] = 1;
+        for (size_t c = 0; c < nres; c++) need[res[c] % m] = 1;
+
+        size_t next = 0;
+        long long vm = 0;
+        for (long long v = 0; next < nres; v++) {
+            const unsigned *prev = v == 0 ? one : zero;
+            for (int j = 0; j < no; j++) {
+                unsigned *slot = ring[j] + (size_t)pos[j] * w;
+                big_add(slot, prev, w);
+                prev = slot;
+                if (++pos[j] == rng[j]) pos[j] = 0;
+            }
+            if (need[vm]) big_add(acc + (size_t)vm * w, prev, w);
+            for (; next < nres && res[next] == v; next++)
+                big_add(ans, acc + (size_t)vm * w, w);
+            if (++vm == m) vm = 0;
+        }
+
+        for (int j = 0; j < no; j++) free(ring[j]);
+        free(ring);
+        free(pos);
+        free(one);
+        free(zero);
+        free(acc);
+        free(need);
+    }
+
+    int nonzero = 0;
+    for (size_t i = 0; i < w; i++) nonzero |= ans[i] != 0;
+    if (!nonzero)
+        printf("No solution.\n");
+    else {
+        printf("Total variants: ");
+        big_print(ans, w);
+        printf("\n");
+    }
+    free(res);
+    free(ans);
+}
+
+/**
+ * Lists the combinations in lexicographic order of (x1, ..., xk).
+ * sufgcd[i] is the gcd of len[i..k-1]: a remainder not divisible by it can
+ * not be completed, so such branches are cut immediately.
+ */
+static long long list_multi(const long long *len, const long long *sufgcd, int k,
+                            int i, long long rem, long long *x) {
+    if (rem % sufgcd[i] != 0) return 0;
+    if (i == k - 1) {
+        x[i] = rem / len[i];
+        for (int j = 0; j < k; j++) {
+            out_str(j ? " + " : "= ", 2 + (j != 0));
+            out_ll(len[j]);
+            out_str(" * ", 3);
+            out_ll(x[j]);
+        }
+        out_str("\n", 1);
+        return 1;
+    }
+    long long cnt = 0;
+    for (x[i] = 0; x[i] <= rem / len[i]; x[i]++)
+        cnt += list_multi(len, sufgcd, k, i + 1, rem - len[i] * x[i], x);
+    return cnt;
+}
+
+/**
+ * Multi-track mode: "k l1 ... lk" followed by the usual "+/- distance".
+ */
+static int run_multi(void) {
+    long long len[MAX_TRACKS], sufgcd[MAX_TRACKS], x[MAX_TRACKS], target;
+    int k;
+    char mode;
+
+    printf("Track lengths:\n");
+    if (scanf("%d", &k) != 1 || k < 2 || k > MAX_TRACKS) {
+        printf("Invalid input.\n");
+        return 0;
+    }
+    for (int i = 0; i < k; i++) {
+        if (scanf("%lld", &len[i]) != 1 || len[i] <= 0) {
+            printf("Invalid input.\n");
+            return 0;
+        }
+        for (int j = 0; j < i; j++)
+            if (len[j] == len[i]) {
+                printf("Invalid input.\n");
+                return 0;
+            }
+    }
+
+    printf("Distance:\n");
+    if (scanf(" %c %lld", &mode, &target) != 2 || (mode != '+' && mode != '-') || target < 0) {
+        printf("Invalid input.\n");
+        return 0;
+    }
+
+    sufgcd[k - 1] = len[k - 1];
+    for (int i = k - 2; i >= 0; i--) sufgcd[i] = gcd(len[i], sufgcd[i + 1]);
+
+    if (mode == '+') {
+        long long count = list_multi(len, sufgcd, k, 0, target, x);
+        out_flush();
+        if (count == 0)
+            printf("No solution.\n");
+        else
+            printf("Total variants: %lld\n", count);
+        return 0;
+    }
+
+    /* Dividing by the common gcd keeps the counting loop as short as possible */
+    if (target % sufgcd[0] != 0) {
+        printf("No solution.\n");
+        return 0;
+    }
+    for (int i = 0; i < k; i++) len[i] /= sufgcd[0];
+    count_multi(len, k, target / sufgcd[0]);
+    return 0;
+}
+
+/* -------------------- QUERY MODE -------------------- */
+
+/* Widest unsigned type available for range totals */
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 wide_t;
+#else
+typedef unsigned long long wide_t;
+#endif
+
+/* Appends a wide number without going through printf */
+static void out_wide(wide_t v) {
+    char tmp[48];
+    int n = 0;
+    if (out_len + sizeof(tmp) > OUT_BUF_SIZE) out_flush();
+    do { tmp[n++] = (char)('0' + (int)(v % 10)); v /= 10; } while (v);
+    while (n) out_buf[out_len++] = tmp[--n];
+}
+
+/**
+ * Sum of floor((a * i + b) / m) for i = 0 .. n-1.
+ * Euclid-like reduction: the sum over one full period of (a * i + b) mod m is
+ * taken in closed form, and the remainder is solved for the swapped roles of
+ * a and m, so the loop runs O(log) times.
+ */
+static wide_t floor_sum(wide_t n, wide_t m, wide_t a, wide_t b) {
+    wide_t ans = 0;
+    for (;;) {
+        if (a >= m) {
+            ans += (n % 2 == 0 ? n / 2 * (n - 1) : (n - 1) / 2 * n) * (a / m);
+            a %= m;
+        }
+        if (b >= m) {
+            ans += n * (b / m);
+            b %= m;
+        }
+        wide_t y_max = a * n + b;
+        if (y_max < m) break;
+        n = y_max / m;
+        b = y_max % m;
+        wide_t t = m; m = a; a = t;
+    }
+    return ans;
+}
+
+/**
+ * Number of pairs x, y >= 0 with a * x + b * y <= r, i.e. the total number of
+ * variants over all distances 0 .. r. For every x the possible y values are
+ * counted at once: sum of floor((r - a * x) / b) + 1, rewritten in the
+ * floor_sum form by running x backwards from floor(r / a).
+ */
+static wide_t variants_upto(long long a, long long b, long long r) {
+    if (r < 0) return 0;
+    long long xmax = r / a;
+    return floor_sum((wide_t)xmax + 1, (wide_t)b, (wide_t)a, (wide_t)(r % a)) + (wide_t)xmax + 1;
+}
+
+/* Writes one result line in the same format as the single-query mode */
+static void out_total(wide_t count) {
+    if (count == 0) {
+        out_str("No solution.\n", 13);
+        return;
+    }
+    out_str("Total variants: ", 16);
+    out_wide(count);
+    out_str("\n", 1);
+}
+
+/**
+ * Query mode: fixed track lengths, then a stream of queries until EOF.
+ *   - D      number of variants for distance D
+ *   ? L R    total number of variants for all distances in [L, R]
+ */
+static int run_queries(void) {
+    long long a, b;
+
+    printf("Track length:\n");
+    if (scanf("%lld %lld", &a, &b) != 2 || a <= 0 || b <= 0 || a == b) {
+        printf("Invalid input.\n");
+        return 0;
+    }
+
+    printf("Queries:\n");
+    fflush(stdout);
+    for (;;) {
+        char op;
+        long long lo, hi;
+        int r = scanf(" %c", &op);
+        if (r == EOF) break;
+        if (r == 1 && op == '-' && scanf("%lld", &lo) == 1 && lo >= 0) {
+            out_total((wide_t)count_variants(a, b, lo, NULL));
+        } else if (r == 1 && op == '?' && scanf("%lld %lld", &lo, &hi) == 2 && lo >= 0 && lo <= hi) {
+            out_total(variants_upto(a, b, hi) - variants_upto(a, b, lo - 1));
+        } else {
+            out_flush();
+            printf("Invalid input.\n");
+            return 0;
+        }
+    }
+    out_flush();
+    return 0;
+}
+
+int main(int argc, char *argv[])
 {
     long long a, b, target;
     char mode;
 
+    if (argc > 1 && strcmp(argv[1], "-k") == 0)
+        return run_multi();
+    if (argc > 1 && strcmp(argv[1], "-q") == 0)
+        return run_queries();
+
     /* Initial Input: Track lengths must be distinct and positive */
     printf("Track length:\n");
     if (scanf("%lld %lld", &a, &b) != 2) {
@@ -46,30 +521,35 @@ int main()
         return 0;
     }
 
-    /* 
-     * Search Algorithm:
-     * Iterates through possible counts of track 'a'. 
-     * Checks if the remaining distance is perfectly divisible by track 'b'.
+    /*
+     * Listing: only valid x values are visited. Starting from the smallest
+     * solution, x grows by b / g and y shrinks by a / g on every step.
      */
     if (mode == '+') {
-        for (long long x = 0; x <= target / a; x++) {
-            long long rem = target - a * x;
-            if (rem % b == 0) {
-                long long y = rem / b;
-                printf("= %lld * %lld + %lld * %lld\n", a, x, b, y);
-                count++;
+        long long x = 0, g = gcd(a, b);
+        count = count_variants(a, b, target, &x);
+        long long y = count ? (target - a * x) / b : 0;
+        for (long long k = 0; k < count; k++) {
+            /* Step before printing, so x never moves past the last solution */
+            if (k) {
+                x += b / g;
+                y -= a / g;
             }
+            out_str("= ", 2);
+            out_ll(a);
+            out_str(" * ", 3);
+            out_ll(x);
+            out_str(" + ", 3);
+            out_ll(b);
+            out_str(" * ", 3);
+            out_ll(y);
+            out_str("\n", 1);
         }
+        out_flush();
     }
     else {
-        /* Optimized search for counting only (Bonus test compliant logic) */
-        for (long long x = 0; x <= target / a; x++) {
-            long long rem = target - a * x;
-            if (rem % b == 0) {
-                long long y = rem / b;
-                if (y >= 0) count++;
-            }
-        }
+        /* Counting only: closed form via the extended Euclidean algorithm */
+        count = count_variants(a, b, target, NULL);
     }
 
     /* Output Results */
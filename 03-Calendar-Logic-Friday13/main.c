@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <time.h>
 
 typedef struct TDate
 {
@@ -60,17 +61,26 @@ static bool legitDate ( TDATE d )
   return true;
 }
 
+/**
+ * Number of leap years in 1 .. yr under the custom rules.
+ */
+static long long leapCount ( long long yr )
+{
+  return yr / 4 - yr / 100 + yr / 400 - yr / 4000;
+}
+
 /**
  * Calculates total days elapsed from Jan 1st, 1900 to the given date.
  * Used for comparing which of two dates comes first.
+ * Closed form: whole years plus their leap days, then the month offset.
  */
 static long long dayCountFrom1900 ( TDATE d )
 {
-  long long total = 0;
-  for ( long long y = BASE_YEAR; y < d.m_Year; ++y )
-    total += leapCalc(y) ? 366 : 365;
-  for ( int m = 1; m < d.m_Month; ++m )
-    total += monthDays(d.m_Year, m);
+  static const int before[12] = {0,31,59,90,120,151,181,212,243,273,304,334};
+  long long y = d.m_Year;
+  long long total = 365 * ( y - BASE_YEAR ) + leapCount(y - 1) - leapCount(BASE_YEAR - 1);
+  total += before[d.m_Month - 1];
+  if ( d.m_Month > 2 && leapCalc(y) ) total++;
   total += d.m_Day - 1;
   return total;
 }
@@ -78,16 +88,18 @@ static long long dayCountFrom1900 ( TDATE d )
 /**
  * Zeller’s Congruence Algorithm
  * Returns the day of the week (0=Sunday, ..., 5=Friday, 6=Saturday).
+ * The last term drops the leap day of every multiple of 4000
+ * (6 * n is -n modulo 7), matching leapCalc.
  */
 static int weekDay ( TDATE d )
 {
-  int y = d.m_Year;
+  long long y = d.m_Year;
   int m = d.m_Month;
   if ( m < 3 ) { m += 12; y -= 1; }
-  int k = y % 100;
-  int j = y / 100;
-  int h = ( d.m_Day + (13*(m + 1))/5 + k + k/4 + j/4 + 5*j ) % 7;
-  int w = ((h + 6) % 7); 
+  long long k = y % 100;
+  long long j = y / 100;
+  long long h = ( d.m_Day + (13*(m + 1))/5 + k + k/4 + j/4 + 5*j + 6*(y/4000) ) % 7;
+  int w = (int)((h + 6) % 7);
   return w;
 }
 
@@ -99,79 +111,660 @@ static bool isFriday13 ( TDATE d )
   return legitDate(d) && d.m_Day == 13 && weekDay(d) == 5;
 }
 
+/*
+ * Under the custom leap rules the calendar repeats every 4000 years, which
+ * is 1460969 days = 6 (mod 7). Seven such cycles, 28000 years, are a whole
+ * number of weeks, so dates and weekdays repeat with this period.
+ */
+#define CAL_PERIOD 28000
+
+/*
+ * Occurrence tables of one (day of month, weekday) pattern, built on first use.
+ * Which months contain the pattern depends only on the year type: leap or
+ * not, and the weekday of January 1st. For each of the 14 types, mask has
+ * bit m-1 set for such months, next[..][m] is the first such month >= m and
+ * prev[..][m] the last one <= m (0 when there is none). prefix[i] is the
+ * number of occurrences in years [0, i) of the period.
+ */
+typedef struct TPattern
+{
+  bool           m_Ready;
+  unsigned short m_Mask[2][7];
+  unsigned char  m_Next[2][7][14];
+  unsigned char  m_Prev[2][7][14];
+  unsigned     * m_Prefix;
+} TPATTERN;
+
+static TPATTERN patterns[31][7];
+
+static int bitCount ( unsigned v )
+{
+  int c = 0;
+  for ( ; v; v &= v - 1 ) ++c;
+  return c;
+}
+
 /**
- * Counts occurrences of Friday 13th between two inclusive dates.
+ * Weekday of January 1st of the given year.
  */
-bool countFriday13 ( TDATE from, TDATE to, long long int * cnt )
+static int jan1WeekDay ( long long yr )
+{
+  return weekDay(makeDate((unsigned)yr, 1, 1));
+}
+
+/**
+ * Returns the tables of the pattern "weekday wday on day day of the month",
+ * building them when asked for the first time. NULL for an invalid pattern
+ * or when memory runs out.
+ */
+static const TPATTERN * patternGet ( int day, int wday )
+{
+  static const int before[12] = {0,31,59,90,120,151,181,212,243,273,304,334};
+  static const int md[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+  if ( day < 1 || day > 31 || wday < 0 || wday > 6 ) return NULL;
+  TPATTERN * p = &patterns[day - 1][wday];
+  if ( p -> m_Ready ) return p;
+
+  for ( int leap = 0; leap < 2; ++leap )
+    for ( int jan1 = 0; jan1 < 7; ++jan1 )
+    {
+      unsigned short mask = 0;
+      for ( int m = 1; m <= 12; ++m )
+      {
+        int len = md[m - 1] + ( leap && m == 2 );
+        if ( day <= len && ( jan1 + before[m - 1] + day - 1 + ( leap && m > 2 ) ) % 7 == wday )
+          mask |= (unsigned short)( 1 << (m - 1) );
+      }
+      p -> m_Mask[leap][jan1] = mask;
+      p -> m_Prev[leap][jan1][0] = 0;
+      for ( int m = 1; m <= 12; ++m )
+        p -> m_Prev[leap][jan1][m] = ( mask >> (m - 1) & 1 ) ? (unsigned char)m : p -> m_Prev[leap][jan1][m - 1];
+      p -> m_Next[leap][jan1][13] = 0;
+      for ( int m = 12; m >= 1; --m )
+        p -> m_Next[leap][jan1][m] = ( mask >> (m - 1) & 1 ) ? (unsigned char)m : p -> m_Next[leap][jan1][m + 1];
+    }
+
+  /* Year CAL_PERIOD + i stands for every year congruent to i */
+  p -> m_Prefix = (unsigned *) malloc(( CAL_PERIOD + 1 ) * sizeof(*p -> m_Prefix));
+  if ( !p -> m_Prefix ) return NULL;
+  p -> m_Prefix[0] = 0;
+  int w = jan1WeekDay(CAL_PERIOD);
+  for ( long long i = 0; i < CAL_PERIOD; ++i )
+  {
+    int leap = leapCalc(CAL_PERIOD + i);
+    p -> m_Prefix[i + 1] = p -> m_Prefix[i] + bitCount(p -> m_Mask[leap][w]);
+    w = ( w + 1 + leap ) % 7;
+  }
+  p -> m_Ready = true;
+  return p;
+}
+
+/**
+ * Number of occurrences in all months before month m (1..13) of year yr,
+ * counted from year 0 of the periodic calendar.
+ */
+static long long patternBefore ( const TPATTERN * p, long long yr, int m )
+{
+  long long r = yr % CAL_PERIOD;
+  return ( yr / CAL_PERIOD ) * p -> m_Prefix[CAL_PERIOD] + p -> m_Prefix[r]
+       + bitCount(p -> m_Mask[leapCalc(yr)][jan1WeekDay(yr)] & ( ( 1u << (m - 1) ) - 1 ));
+}
+
+/**
+ * Counts the dates between two inclusive dates that fall on the given day of
+ * the month and weekday (0=Sunday, ..., 6=Saturday).
+ * O(1): the count is a difference of two period-table lookups.
+ */
+bool countWeekdayOnDay ( TDATE from, TDATE to, int day, int wday, long long int * cnt )
 {
   if ( !cnt || !legitDate(from) || !legitDate(to) ) return false;
   if ( dayCountFrom1900(to) < dayCountFrom1900(from) ) return false;
-  
-  long long res = 0;
-  long long y1 = from.m_Year, y2 = to.m_Year;
-  int startM = from.m_Month, endM = to.m_Month;
+  const TPATTERN * p = patternGet(day, wday);
+  if ( !p ) return false;
+
+  /* First month whose occurrence is not before from, first month after the last one not after to */
+  long long lo = patternBefore(p, from.m_Year, from.m_Month + ( from.m_Day > day ));
+  long long hi = patternBefore(p, to.m_Year, to.m_Month + ( to.m_Day >= day ));
+  *cnt = hi > lo ? hi - lo : 0;
+  return true;
+}
 
-  for ( long long y = y1; y <= y2; ++y )
+/**
+ * Modifies the provided date to the nearest preceding date with the given
+ * day of the month and weekday. The current year needs one table lookup;
+ * the rare patterns missing from a whole year (day 31) step back a few
+ * years, each year's type following from the previous one.
+ */
+bool prevWeekdayOnDay ( TDATE * date, int day, int wday )
+{
+  if ( !date || !legitDate(*date) ) return false;
+  const TPATTERN * p = patternGet(day, wday);
+  if ( !p ) return false;
+  long long y = date->m_Year;
+  int m = date->m_Month - ( date->m_Day <= day );
+  int w = jan1WeekDay(y);
+  int found = m >= 1 ? p -> m_Prev[leapCalc(y)][w][m] : 0;
+  while ( !found )
   {
-    int mStart = ( y == y1 ? startM : 1 );
-    int mEnd = ( y == y2 ? endM : 12 );
-    for ( int m = mStart; m <= mEnd; ++m )
-    {
-      TDATE chk = makeDate(y, m, 13);
-      if ( !legitDate(chk) ) continue;
-      if ( dayCountFrom1900(chk) < dayCountFrom1900(from) ||
-           dayCountFrom1900(chk) > dayCountFrom1900(to) )
-        continue;
-      if ( isFriday13(chk) ) ++res;
-    }
+    if ( y - 1 < BASE_YEAR ) return false;
+    --y;
+    w = ( w + 6 - leapCalc(y) ) % 7;
+    found = p -> m_Prev[leapCalc(y)][w][12];
   }
-  *cnt = res;
+  *date = makeDate((unsigned)y, (unsigned short)found, (unsigned short)day);
   return true;
 }
 
+/**
+ * Modifies the provided date to the nearest succeeding date with the given
+ * day of the month and weekday.
+ */
+bool nextWeekdayOnDay ( TDATE * date, int day, int wday )
+{
+  if ( !date || !legitDate(*date) ) return false;
+  const TPATTERN * p = patternGet(day, wday);
+  if ( !p ) return false;
+  long long y = date->m_Year;
+  int m = date->m_Month + ( date->m_Day >= day );
+  int w = jan1WeekDay(y);
+  int found = m <= 12 ? p -> m_Next[leapCalc(y)][w][m] : 0;
+  while ( !found )
+  {
+    if ( y + 1 > (long long)(unsigned)-1 ) return false;
+    w = ( w + 1 + leapCalc(y) ) % 7;
+    ++y;
+    found = p -> m_Next[leapCalc(y)][w][1];
+  }
+  *date = makeDate((unsigned)y, (unsigned short)found, (unsigned short)day);
+  return true;
+}
+
+/**
+ * Counts occurrences of Friday 13th between two inclusive dates.
+ */
+bool countFriday13 ( TDATE from, TDATE to, long long int * cnt )
+{
+  return countWeekdayOnDay(from, to, 13, 5, cnt);
+}
+
 /**
  * Modifies the provided date to the nearest preceding Friday 13th.
  */
 bool prevFriday13 ( TDATE * date )
 {
-  if ( !date || !legitDate(*date) ) return false;
-  int y = date->m_Year;
-  int m = date->m_Month;
-  while (1)
+  return prevWeekdayOnDay(date, 13, 5);
+}
+
+/**
+ * Modifies the provided date to the nearest succeeding Friday 13th.
+ */
+bool nextFriday13 ( TDATE * date )
+{
+  return nextWeekdayOnDay(date, 13, 5);
+}
+
+/*
+ * Batch interface: structure-of-arrays inputs, one result per element.
+ * The loop bodies are branch free and use only 32-bit arithmetic and table
+ * lookups, so the compiler can vectorize them; results are identical to the
+ * scalar functions for every input, valid or not.
+ */
+
+/**
+ * weekDay for n dates. Same congruence as weekDay: the only input where the
+ * adjusted year goes negative is year 0 in January/February, where the
+ * year terms of the scalar version sum to -1.
+ */
+void weekDayBatch ( const unsigned * years, const unsigned short * months,
+                    const unsigned short * days, size_t n, int * out )
+{
+  for ( size_t i = 0; i < n; ++i )
+  {
+    unsigned m = months[i];
+    unsigned early = m < 3;
+    unsigned neg = early & ( years[i] == 0 );
+    unsigned y = years[i] - early + neg;
+    unsigned k = y % 100, j = y / 100;
+    unsigned yearTerms = k + k / 4 + j / 4 + 5 * j + 6 * ( y / 4000 ) - neg;
+    unsigned h = ( days[i] + ( 13 * ( m + 12 * early + 1 ) ) / 5 + yearTerms ) % 7;
+    out[i] = (int)( ( h + 6 ) % 7 );
+  }
+}
+
+/**
+ * legitDate for n dates.
+ */
+void legitDateBatch ( const unsigned * years, const unsigned short * months,
+                      const unsigned short * days, size_t n, bool * out )
+{
+  static const unsigned md[13] = {0,31,28,31,30,31,30,31,31,30,31,30,31};
+  for ( size_t i = 0; i < n; ++i )
   {
-    TDATE cand = makeDate(y, m, 13);
-    if ( legitDate(cand) && dayCountFrom1900(cand) < dayCountFrom1900(*date) && isFriday13(cand) )
+    unsigned y = years[i], m = months[i], d = days[i];
+    unsigned leap = ( y % 4 == 0 ) & ( ( y % 100 != 0 ) | ( y % 400 == 0 ) ) & ( y % 4000 != 0 );
+    unsigned len = md[m * ( m <= 12 )] + ( leap & ( m == 2 ) );
+    out[i] = ( y >= BASE_YEAR ) & ( m >= 1 ) & ( d >= 1 ) & ( d <= len );
+  }
+}
+
+/**
+ * countFriday13 for n intervals [from, to]. ok[i] receives the return value
+ * of countFriday13, cnt[i] is only written where ok[i] is true.
+ */
+void countFriday13Batch ( const unsigned * fromYears, const unsigned short * fromMonths,
+                          const unsigned short * fromDays, const unsigned * toYears,
+                          const unsigned short * toMonths, const unsigned short * toDays,
+                          size_t n, long long int * cnt, bool * ok )
+{
+  for ( size_t i = 0; i < n; ++i )
+    ok[i] = countFriday13(makeDate(fromYears[i], fromMonths[i], fromDays[i]),
+                          makeDate(toYears[i], toMonths[i], toDays[i]), &cnt[i]);
+}
+
+#ifndef __PROGTEST__
+/**
+ * Like assert, but kept in NDEBUG builds: reports the failed check and exits.
+ */
+#define CHECK(cond)                                                          \
+  do {                                                                       \
+    if ( !( cond ) )                                                         \
+    {                                                                        \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      exit(EXIT_FAILURE);                                                    \
+    }                                                                        \
+  } while ( 0 )
+
+/**
+ * Reports a count that differs from the reference (or was refused) and exits.
+ */
+static void checkCount ( const char * what, TDATE from, TDATE to, bool ok, long long got, long long ref )
+{
+  if ( ok && got == ref ) return;
+  fprintf(stderr, "%s(%u-%02u-%02u, %u-%02u-%02u): ", what,
+          from.m_Year, from.m_Month, from.m_Day, to.m_Year, to.m_Month, to.m_Day);
+  if ( ok ) fprintf(stderr, "got %lld, expected %lld\n", got, ref);
+  else fprintf(stderr, "refused, expected %lld\n", ref);
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * Reference implementation of dayCountFrom1900: adds up the years one by one.
+ */
+static long long dayCountLoop ( TDATE d )
+{
+  long long total = 0;
+  for ( long long y = BASE_YEAR; y < d.m_Year; ++y )
+    total += leapCalc(y) ? 366 : 365;
+  for ( int m = 1; m < d.m_Month; ++m )
+    total += monthDays(d.m_Year, m);
+  total += d.m_Day - 1;
+  return total;
+}
+
+/**
+ * Random valid date; every fourth year is taken next to a 100/400/4000 boundary.
+ */
+static TDATE randomDate ( unsigned maxYear )
+{
+  unsigned y = BASE_YEAR + (unsigned)rand() % ( maxYear - BASE_YEAR + 1 );
+  if ( rand() % 4 == 0 )
+  {
+    static const unsigned step[3] = { 100, 400, 4000 };
+    unsigned s = step[rand() % 3];
+    y = y / s * s + (unsigned)( rand() % 3 );
+    y = y > BASE_YEAR ? y - 1 : BASE_YEAR;
+  }
+  unsigned short m = (unsigned short)( 1 + rand() % 12 );
+  unsigned short d = (unsigned short)( 1 + rand() % monthDays(y, m) );
+  return makeDate(y, m, d);
+}
+
+/**
+ * Correctness checks of the optimized functions against simple reference code.
+ */
+static void runTests ( void )
+{
+  /* Differential test: closed-form day count against the year loop */
+  srand(12345);
+  for ( int i = 0; i < 200000; ++i )
+  {
+    TDATE d = randomDate(i % 10 ? 3000 : 40000);
+    CHECK ( dayCountFrom1900(d) == dayCountLoop(d) );
+  }
+  CHECK ( dayCountFrom1900(makeDate(1900, 1, 1)) == 0 );
+  CHECK ( dayCountFrom1900(makeDate(4000, 3, 1)) == dayCountLoop(makeDate(4000, 3, 1)) );
+  CHECK ( dayCountFrom1900(makeDate(2000, 3, 1)) == dayCountLoop(makeDate(2000, 3, 1)) );
+
+  /* Weekdays follow the day count (1900-01-01 was a Monday) */
+  for ( int i = 0; i < 200000; ++i )
+  {
+    TDATE d = randomDate(i % 10 ? 3000 : 4000000);
+    CHECK ( weekDay(d) == (int)( ( dayCountFrom1900(d) + 1 ) % 7 ) );
+  }
+
+  /* Table-based countFriday13 against a month by month scan */
+  for ( int i = 0; i < 20000; ++i )
+  {
+    TDATE a = randomDate(i % 200 ? 2100 : 60000), b = randomDate(i % 200 ? 2100 : 60000);
+    long long cnt, ref = 0;
+    if ( dayCountFrom1900(b) < dayCountFrom1900(a) ) { TDATE t = a; a = b; b = t; }
+    for ( unsigned y = a.m_Year; y <= b.m_Year; ++y )
+      for ( unsigned short m = 1; m <= 12; ++m )
+      {
+        TDATE c = makeDate(y, m, 13);
+        if ( dayCountFrom1900(c) >= dayCountFrom1900(a) && dayCountFrom1900(c) <= dayCountFrom1900(b) && isFriday13(c) )
+          ++ref;
+      }
+    bool ok = countFriday13(a, b, &cnt);
+    checkCount("countFriday13", a, b, ok, cnt, ref);
+  }
+  /* Table-based prev/next against a month by month walk */
+  for ( int i = 0; i < 200000; ++i )
+  {
+    TDATE d = randomDate(i % 10 ? 3000 : 4000000), p = d, n = d, rp, rn;
+    bool hasPrev = false;
+    for ( long long y = d.m_Year, m = d.m_Month; y >= BASE_YEAR && !hasPrev; )
+    {
+      rp = makeDate((unsigned)y, (unsigned short)m, 13);
+      hasPrev = dayCountFrom1900(rp) < dayCountFrom1900(d) && isFriday13(rp);
+      if ( --m < 1 ) { m = 12; --y; }
+    }
+    for ( long long y = d.m_Year, m = d.m_Month; ; )
+    {
+      rn = makeDate((unsigned)y, (unsigned short)m, 13);
+      if ( dayCountFrom1900(rn) > dayCountFrom1900(d) && isFriday13(rn) ) break;
+      if ( ++m > 12 ) { m = 1; ++y; }
+    }
+    CHECK ( prevFriday13(&p) == hasPrev );
+    CHECK ( !hasPrev || equalDate(p, rp) );
+    CHECK ( nextFriday13(&n) && equalDate(n, rn) );
+  }
+
+  /* Batch functions against the scalar ones, including invalid dates */
+  {
+    enum { N = 4096 };
+    static unsigned years[N], toYears[N];
+    static unsigned short months[N], days[N], toMonths[N], toDays[N];
+    static int wd[N];
+    static bool legit[N], ok[N];
+    static long long cnts[N];
+    for ( int round = 0; round < 50; ++round )
     {
-      *date = cand;
-      return true;
+      for ( int i = 0; i < N; ++i )
+      {
+        TDATE d = randomDate(round % 2 ? 3000 : 4000000), e = randomDate(3000);
+        if ( i % 5 == 0 )
+        {
+          d.m_Year = (unsigned)rand() * 3u;
+          d.m_Month = (unsigned short)( rand() % 16 );
+          d.m_Day = (unsigned short)( rand() % 34 );
+        }
+        if ( i % 97 == 0 ) d.m_Year = i % 2 ? 0 : 4294967295u;
+        years[i] = d.m_Year; months[i] = d.m_Month; days[i] = d.m_Day;
+        toYears[i] = e.m_Year; toMonths[i] = e.m_Month; toDays[i] = e.m_Day;
+      }
+      weekDayBatch(years, months, days, N, wd);
+      legitDateBatch(years, months, days, N, legit);
+      countFriday13Batch(years, months, days, toYears, toMonths, toDays, N, cnts, ok);
+      for ( int i = 0; i < N; ++i )
+      {
+        TDATE d = makeDate(years[i], months[i], days[i]);
+        long long c;
+        bool r = countFriday13(d, makeDate(toYears[i], toMonths[i], toDays[i]), &c);
+        CHECK ( wd[i] == weekDay(d) );
+        CHECK ( legit[i] == legitDate(d) );
+        CHECK ( ok[i] == r && ( !r || cnts[i] == c ) );
+      }
     }
-    if (--m < 1) { m = 12; y--; }
-    if ( y < BASE_YEAR ) return false;
   }
-  return false;
+
+  /* Other patterns against a day by day walk over random short intervals */
+  for ( int i = 0; i < 20000; ++i )
+  {
+    int day = 1 + rand() % 31, wday = rand() % 7;
+    TDATE a = randomDate(i % 10 ? 2500 : 40000), b = a, p = a, n = a;
+    long long cnt, ref = 0;
+    for ( int k = rand() % 3000; ; --k )
+    {
+      ref += b.m_Day == day && weekDay(b) == wday;
+      if ( k == 0 ) break;
+      if ( ++b.m_Day > monthDays(b.m_Year, b.m_Month) )
+      {
+        b.m_Day = 1;
+        if ( ++b.m_Month > 12 ) { b.m_Month = 1; ++b.m_Year; }
+      }
+    }
+    bool ok = countWeekdayOnDay(a, b, day, wday, &cnt);
+    checkCount("countWeekdayOnDay", a, b, ok, cnt, ref);
+    if ( nextWeekdayOnDay(&n, day, wday) )
+    {
+      long long cn;
+      CHECK ( n.m_Day == day && weekDay(n) == wday && legitDate(n) );
+      CHECK ( countWeekdayOnDay(a, n, day, wday, &cn) && cn == 1 + ( a.m_Day == day && weekDay(a) == wday ) );
+    }
+    if ( prevWeekdayOnDay(&p, day, wday) )
+    {
+      long long cp;
+      CHECK ( p.m_Day == day && weekDay(p) == wday && legitDate(p) );
+      CHECK ( countWeekdayOnDay(p, a, day, wday, &cp) && cp == 1 + ( a.m_Day == day && weekDay(a) == wday ) );
+    }
+  }
+
+  long long cnt;
+  CHECK ( !countWeekdayOnDay(makeDate(2000, 1, 1), makeDate(2001, 1, 1), 32, 5, &cnt) );
+  CHECK ( !countWeekdayOnDay(makeDate(2000, 1, 1), makeDate(2001, 1, 1), 1, 7, &cnt) );
+  TDATE tmp = makeDate(1900, 1, 1);
+  CHECK ( !prevFriday13(&tmp) );
+  tmp = makeDate(4294967295u, 12, 31);
+  CHECK ( !nextFriday13(&tmp) );
+  tmp = makeDate(4294967295u, 1, 1);
+  CHECK ( prevFriday13(&tmp) && tmp.m_Year == 4294967294u );
+  CHECK ( countFriday13(makeDate(2015, 1, 1), makeDate(2015, 12, 31), &cnt) && cnt == 3 );
+  CHECK ( countFriday13(makeDate(2015, 2, 13), makeDate(2015, 2, 13), &cnt) && cnt == 1 );
+  CHECK ( countFriday13(makeDate(2015, 2, 14), makeDate(2015, 3, 12), &cnt) && cnt == 0 );
+  CHECK ( !countFriday13(makeDate(2015, 3, 1), makeDate(2015, 2, 1), &cnt) );
 }
 
 /**
- * Modifies the provided date to the nearest succeeding Friday 13th.
+ * Moves a valid date by the given number of days (forward only).
  */
-bool nextFriday13 ( TDATE * date )
+static TDATE addDays ( TDATE d, long long n )
 {
-  if ( !date || !legitDate(*date) ) return false;
-  int y = date->m_Year;
-  int m = date->m_Month;
-  while (1)
+  while ( n-- > 0 )
+    if ( ++d.m_Day > monthDays(d.m_Year, d.m_Month) )
+    {
+      d.m_Day = 1;
+      if ( ++d.m_Month > 12 ) { d.m_Month = 1; ++d.m_Year; }
+    }
+  return d;
+}
+
+/**
+ * Brute-force oracle: visits every day of [from, to], tracking the weekday
+ * with a counter instead of calling weekDay.
+ */
+static long long oracleCount ( TDATE from, TDATE to )
+{
+  long long res = 0, last = dayCountFrom1900(to);
+  int w = (int)( ( dayCountFrom1900(from) + 1 ) % 7 );
+  for ( long long dc = dayCountFrom1900(from); dc <= last; ++dc )
+  {
+    res += from.m_Day == 13 && w == 5;
+    from = addDays(from, 1);
+    w = ( w + 1 ) % 7;
+  }
+  return res;
+}
+
+/**
+ * Brute-force oracle of nextFriday13 / prevFriday13 (dir = +1 / -1).
+ */
+static bool oracleStep ( TDATE * date, int dir )
+{
+  TDATE d = *date;
+  int w = (int)( ( dayCountFrom1900(d) + 1 ) % 7 );
+  for ( ;; )
   {
-    TDATE cand = makeDate(y, m, 13);
-    if ( legitDate(cand) && dayCountFrom1900(cand) > dayCountFrom1900(*date) && isFriday13(cand) )
+    if ( dir > 0 )
     {
-      *date = cand;
-      return true;
+      if ( d.m_Year == 4294967295u && d.m_Month == 12 && d.m_Day == 31 ) return false;
+      d = addDays(d, 1);
     }
-    if (++m > 12) { m = 1; y++; }
+    else
+    {
+      if ( d.m_Year == BASE_YEAR && d.m_Month == 1 && d.m_Day == 1 ) return false;
+      if ( --d.m_Day < 1 )
+      {
+        if ( --d.m_Month < 1 ) { d.m_Month = 12; --d.m_Year; }
+        d.m_Day = (unsigned short)monthDays(d.m_Year, d.m_Month);
+      }
+    }
+    w = ( w + 7 + dir ) % 7;
+    if ( d.m_Day == 13 && w == 5 ) break;
   }
-  return false;
+  *date = d;
+  return true;
 }
 
-#ifndef __PROGTEST__
-/* Example main and testing logic would go here */
-#endif
+/* periodPrefix[i]: Friday 13ths in the years [BASE_YEAR, BASE_YEAR + i) */
+static long long periodPrefix[CAL_PERIOD + 1];
+
+/**
+ * Walks one whole calendar period day by day, counting Friday 13ths per year.
+ * The walk must end on the weekday it started on, or the counts would not
+ * repeat with the period.
+ */
+static void buildPeriodOracle ( void )
+{
+  TDATE d = makeDate(BASE_YEAR, 1, 1);
+  int w = 1; /* 1900-01-01 was a Monday */
+  for ( int i = 0; i < CAL_PERIOD; ++i )
+  {
+    long long c = 0;
+    for ( unsigned y = d.m_Year; d.m_Year == y; d = addDays(d, 1), w = ( w + 1 ) % 7 )
+      c += d.m_Day == 13 && w == 5;
+    periodPrefix[i + 1] = periodPrefix[i] + c;
+  }
+  CHECK ( w == 1 && equalDate(d, makeDate(BASE_YEAR + CAL_PERIOD, 1, 1)) );
+}
+
+/* Friday 13ths in the whole years [BASE_YEAR, y), from the period table */
+static long long oracleYearsBefore ( long long y )
+{
+  long long k = y - BASE_YEAR;
+  return k / CAL_PERIOD * periodPrefix[CAL_PERIOD] + periodPrefix[k % CAL_PERIOD];
+}
+
+/**
+ * Oracle for intervals too long to walk: the partial first and last years
+ * are walked, the whole years in between come from the period table.
+ */
+static long long oracleCountLong ( TDATE from, TDATE to )
+{
+  if ( from.m_Year == to.m_Year ) return oracleCount(from, to);
+  return oracleCount(from, makeDate(from.m_Year, 12, 31))
+       + oracleYearsBefore(to.m_Year) - oracleYearsBefore((long long)from.m_Year + 1)
+       + oracleCount(makeDate(to.m_Year, 1, 1), to);
+}
+
+static double nsPerCall ( clock_t start, long calls )
+{
+  return (double)( clock() - start ) * 1e9 / CLOCKS_PER_SEC / (double)calls;
+}
+
+/**
+ * Times countFriday13 / prevFriday13 / nextFriday13 over intervals from one
+ * day to 10^9 years and checks the timed results against the oracles: every
+ * count, and prev/next for the first 256 samples of each row.
+ */
+static void runBenchmark ( void )
+{
+  enum { SAMPLES = 4096, REPEAT = 64 };
+  static TDATE from[SAMPLES], to[SAMPLES];
+  static const long long spanYears[] = { 0, 0, 1, 10, 100, 1000, 10000, 100000,
+                                         1000000, 10000000, 100000000, 1000000000 };
+  static const long long spanDays[] = { 1, 30 };
+  volatile long long sink = 0;
+
+  buildPeriodOracle();
+  srand(4242);
+  printf("%-20s %12s %12s %12s %8s\n", "interval", "count ns", "prev ns", "next ns", "checked");
+  for ( size_t s = 0; s < sizeof(spanYears) / sizeof(spanYears[0]); ++s )
+  {
+    char label[32];
+    long long years = spanYears[s];
+    if ( s < 2 ) snprintf(label, sizeof(label), "%lld day(s)", spanDays[s]);
+    else snprintf(label, sizeof(label), "%lld year(s)", years);
+
+    for ( int i = 0; i < SAMPLES; ++i )
+    {
+      from[i] = randomDate(years >= 1000000 ? 3000000000u : 1000000u);
+      if ( s < 2 )
+        to[i] = addDays(from[i], spanDays[s]);
+      else
+      {
+        to[i] = from[i];
+        to[i].m_Year += (unsigned)years;
+        if ( to[i].m_Day > monthDays(to[i].m_Year, to[i].m_Month) ) to[i].m_Day = 28;
+      }
+    }
+
+    /* Correctness: day walk for intervals up to 100 years, period oracle beyond */
+    int checked = 0;
+    for ( int i = 0; i < SAMPLES; ++i )
+    {
+      long long cnt;
+      bool ok = countFriday13(from[i], to[i], &cnt);
+      checkCount("countFriday13", from[i], to[i], ok, cnt,
+                 years <= 100 ? oracleCount(from[i], to[i]) : oracleCountLong(from[i], to[i]));
+      ++checked;
+      if ( i < 256 )
+      {
+        TDATE p = from[i], rp = from[i], n = to[i], rn = to[i];
+        bool hp = prevFriday13(&p), hn = nextFriday13(&n);
+        CHECK ( hp == oracleStep(&rp, -1) && ( !hp || equalDate(p, rp) ) );
+        CHECK ( hn == oracleStep(&rn, 1) && ( !hn || equalDate(n, rn) ) );
+      }
+    }
+
+    /* Speed */
+    clock_t start = clock();
+    for ( int r = 0; r < REPEAT; ++r )
+      for ( int i = 0; i < SAMPLES; ++i )
+      {
+        long long cnt;
+        countFriday13(from[i], to[i], &cnt);
+        sink += cnt;
+      }
+    double countNs = nsPerCall(start, (long)REPEAT * SAMPLES);
+
+    start = clock();
+    for ( int r = 0; r < REPEAT; ++r )
+      for ( int i = 0; i < SAMPLES; ++i )
+      {
+        TDATE d = to[i];
+        sink += prevFriday13(&d) ? d.m_Month : 0;
+      }
+    double prevNs = nsPerCall(start, (long)REPEAT * SAMPLES);
+
+    start = clock();
+    for ( int r = 0; r < REPEAT; ++r )
+      for ( int i = 0; i < SAMPLES; ++i )
+      {
+        TDATE d = from[i];
+        sink += nextFriday13(&d) ? d.m_Month : 0;
+      }
+    double nextNs = nsPerCall(start, (long)REPEAT * SAMPLES);
+
+    printf("%-20s %12.1f %12.1f %12.1f %8d\n", label, countNs, prevNs, nextNs, checked);
+  }
+  (void) sink;
+}
+
+int main ( void )
+{
+  runTests();
+  runBenchmark();
+  return EXIT_SUCCESS;
+}
+#endif /* __PROGTEST__ */
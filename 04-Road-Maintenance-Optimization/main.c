@@ -1,15 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include <limits.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
 
 typedef long long ll;
+typedef unsigned long long ull;
 
 /* Structure definitions for Date, History tracking, and Assignments */
 typedef struct { int y, m, d; } Date;
-typedef struct { ll day; int cost; } CostEntry;
-typedef struct { CostEntry *entries; size_t count, capacity; } CostHistory;
+typedef struct { ll day; int cost; ull acc; } CostEntry; /* acc: cost integral over days [0, day), mod 2^64 */
+typedef struct { size_t off, count, capacity; } CostHistory; /* slice of the CostArena */
 typedef struct { int s1, e1, s2, e2; } Assignment;
 typedef struct { Assignment *items; size_t count, capacity; } AssignmentList;
 
@@ -42,81 +45,231 @@ static int date_to_days(const Date *dt, ll *out){
     return 1;
 }
 
-static const char* skipws(const char *s){ while(*s && isspace((unsigned char)*s)) s++; return s; }
+/* C-locale character classes, cheaper than the <ctype.h> table lookups on the hot parsing path */
+static int is_space(int c){ return c == ' ' || (c >= '\t' && c <= '\r'); }
+static int is_digit(int c){ return (unsigned)(c - '0') < 10; }
 
-static const char* parse_date(const char *s, Date *d){
+static const char* skipws(const char *s){ while(is_space((unsigned char)*s)) s++; return s; }
+
+/**
+ * Equivalent of scanf's "%d" (width 0) or "%2d": blanks, an optional sign and
+ * digits, at most `width` characters. Values too large for an int saturate.
+ */
+static const char* scan_int(const char *s, int width, ll *out){
+    while(is_space((unsigned char)*s)) s++;
+    int neg = 0, used = 0, digits = 0;
+    if(*s == '+' || *s == '-'){ neg = (*s == '-'); s++; used++; }
+    ll v = 0;
+    while(is_digit((unsigned char)*s) && (!width || used < width)){
+        if(v <= INT_MAX) v = v*10 + (*s - '0');
+        s++; used++; digits++;
+    }
+    if(!digits) return NULL;
+    *out = neg ? -v : v;
+    return s;
+}
+
+/**
+ * Parses "YYYY-MM-DD" in place with the same acceptance as sscanf("%d-%2d-%2d").
+ * Returns the end of the whitespace-delimited token; if `scanned` is given it
+ * receives the end of the characters the date actually consumed.
+ */
+static const char* parse_date(const char *s, Date *d, const char **scanned){
     s = skipws(s);
-    int y,m,dd;
-    if (sscanf(s, "%d-%2d-%2d", &y, &m, &dd) != 3) return NULL;
-    if (!is_valid_date(y,m,dd)) return NULL;
-    d->y=y; d->m=m; d->d=dd;
-    while(*s && !isspace((unsigned char)*s)) s++;
+    ll y, m, dd;
+    const char *p = scan_int(s, 0, &y);
+    if(!p || *p++ != '-' || !(p = scan_int(p, 2, &m)) || *p++ != '-' || !(p = scan_int(p, 2, &dd))) return NULL;
+    if(y > INT_MAX || !is_valid_date((int)y, (int)m, (int)dd)) return NULL;
+    d->y=(int)y; d->m=(int)m; d->d=(int)dd;
+    if(scanned) *scanned = p;
+    while(*s && !is_space((unsigned char)*s)) s++;
     return s;
 }
 
-/* Cost History Management: Allows retrieval of costs for any specific day */
-static void init_history(CostHistory *h){ h->entries=NULL; h->count=h->capacity=0; }
-static void free_history(CostHistory *h){ free(h->entries); }
-static void add_cost(CostHistory *h, ll day, int cost){
+/*
+ * Block-buffered reader over stdin. Lines are handed out in place, NUL
+ * terminated inside the buffer, so nothing is copied. read(2) returns
+ * whatever is available, so interactive input is still answered line by line.
+ */
+#define READ_BUF_SIZE (1 << 20)
+
+typedef struct {
+    char *buf;
+    size_t pos, len, cap;
+    int eof;
+} Reader;
+
+static void init_reader(Reader *rd){
+    rd->cap = READ_BUF_SIZE;
+    rd->buf = (char*)safe_malloc(rd->cap + 1);
+    rd->pos = rd->len = 0;
+    rd->eof = 0;
+    rd->buf[0] = '\0';
+}
+static void free_reader(Reader *rd){ free(rd->buf); }
+
+/* Moves the unread tail to the front (growing the buffer for very long lines) and appends input */
+static void reader_fill(Reader *rd){
+    size_t rest = rd->len - rd->pos;
+    memmove(rd->buf, rd->buf + rd->pos, rest);
+    rd->pos = 0;
+    rd->len = rest;
+    if(rd->len == rd->cap){
+        rd->cap *= 2;
+        rd->buf = (char*)safe_realloc(rd->buf, rd->cap + 1);
+    }
+    if(!rd->eof){
+        ssize_t got;
+        do got = read(STDIN_FILENO, rd->buf + rd->len, rd->cap - rd->len); while(got < 0 && errno == EINTR);
+        if(got <= 0) rd->eof = 1;
+        else rd->len += (size_t)got;
+    }
+    rd->buf[rd->len] = '\0';
+}
+
+static int reader_getc(Reader *rd){
+    while(rd->pos == rd->len){
+        if(rd->eof) return EOF;
+        reader_fill(rd);
+    }
+    return (unsigned char)rd->buf[rd->pos++];
+}
+
+/* Next input line without its newline, or NULL at the end of input */
+static char* reader_line(Reader *rd){
+    for(;;){
+        char *line = rd->buf + rd->pos;
+        char *nl = (char*)memchr(line, '\n', rd->len - rd->pos);
+        if(nl){
+            *nl = '\0';
+            rd->pos = (size_t)(nl - rd->buf) + 1;
+            return line;
+        }
+        if(rd->eof){
+            if(rd->pos == rd->len) return NULL;
+            rd->pos = rd->len;
+            return line;
+        }
+        reader_fill(rd);
+    }
+}
+
+/*
+ * Cost History Arena. All histories live in one contiguous CostEntry array
+ * and a section owns the slice [off, off+capacity). A full section grows in
+ * place when its slice is the last one, otherwise it moves to the end with
+ * twice the room. Abandoned slices are counted as waste and the arena is
+ * compacted (in section order) once they make up half of it.
+ */
+typedef struct {
+    CostEntry *data;
+    size_t used, cap, waste;
+    CostHistory *sec;
+    size_t n;
+} CostArena;
+
+static size_t arena_reserve(CostArena *A, size_t len){
+    if(A->used + len > A->cap){
+        size_t nc = A->cap ? A->cap*2 : 64;
+        while(nc < A->used + len) nc *= 2;
+        A->data = (CostEntry*)safe_realloc(A->data, nc * sizeof(CostEntry));
+        A->cap = nc;
+    }
+    size_t off = A->used;
+    A->used += len;
+    return off;
+}
+
+static void init_arena(CostArena *A, size_t n){
+    A->data = NULL; A->used = A->cap = A->waste = 0;
+    A->n = n;
+    A->sec = (CostHistory*)safe_malloc(n * sizeof(CostHistory));
+    for(size_t i=0; i<n; i++){
+        A->sec[i].off = arena_reserve(A, 2);
+        A->sec[i].count = 0;
+        A->sec[i].capacity = 2;
+    }
+}
+static void free_arena(CostArena *A){ free(A->data); free(A->sec); }
+
+static void compact_arena(CostArena *A){
+    CostEntry *nd = (CostEntry*)safe_malloc(A->cap * sizeof(CostEntry));
+    size_t pos = 0;
+    for(size_t i=0; i<A->n; i++){
+        CostHistory *h = &A->sec[i];
+        memcpy(nd + pos, A->data + h->off, h->count * sizeof(CostEntry));
+        h->off = pos;
+        pos += h->capacity;
+    }
+    free(A->data);
+    A->data = nd; A->used = pos; A->waste = 0;
+}
+
+static void add_cost(CostArena *A, size_t idx, ll day, int cost){
+    CostHistory *h = &A->sec[idx];
     if(h->count==h->capacity){
-        size_t nc = h->capacity ? h->capacity*2 : 4;
-        h->entries = (CostEntry*)safe_realloc(h->entries, nc * sizeof(CostEntry));
+        size_t nc = h->capacity*2;
+        if(h->off + h->capacity == A->used) arena_reserve(A, nc - h->capacity);
+        else {
+            size_t off = arena_reserve(A, nc);
+            memcpy(A->data + off, A->data + h->off, h->count * sizeof(CostEntry));
+            A->waste += h->capacity;
+            h->off = off;
+        }
         h->capacity = nc;
+        if(2*A->waste > A->used) compact_arena(A);
+    }
+    CostEntry *e = &A->data[h->off + h->count];
+    e->day = day;
+    e->cost = cost;
+    e->acc = 0;
+    if(h->count > 0){
+        const CostEntry *p = e - 1;
+        e->acc = p->acc + (ull)(day - p->day) * (ull)(ll)p->cost;
     }
-    h->entries[h->count].day = day;
-    h->entries[h->count].cost = cost;
     h->count++;
 }
 
+/**
+ * Cost integral over days [0, x): the running integral stored at the last
+ * change on or before x, plus the days since that change at its cost.
+ * The integral from day 0 can exceed long long even when a queried range
+ * does not, so it is kept modulo 2^64; the difference of two integrals is
+ * then exact whenever the range total itself fits.
+ */
+static ull cost_before(const CostEntry *entries, size_t count, ll x){
+    size_t lo = 0, hi = count;
+    while(lo < hi){
+        size_t mid = lo + (hi - lo) / 2;
+        if(entries[mid].day <= x) lo = mid + 1;
+        else hi = mid;
+    }
+    if(lo == 0) return 0;
+    const CostEntry *e = &entries[lo - 1];
+    return e->acc + (ull)(x - e->day) * (ull)(ll)e->cost;
+}
+
 /**
  * Aggregates the total maintenance cost for a section over a date range [start, end].
+ * Two binary searches over the change points, O(log k).
  */
-static ll compute_total(const CostHistory *h, ll start, ll end){
+static ll compute_total(const CostArena *A, size_t idx, ll start, ll end){
+    const CostHistory *h = &A->sec[idx];
     if(start>end || h->count==0) return 0;
-    ll total=0;
-    size_t i=0;
-    while(i<h->count && h->entries[i].day <= start) i++;
-    if(i>0) i--;
-    ll cur=start;
-    while(cur<=end && i<h->count){
-        ll s = cur;
-        ll e = (i+1<h->count) ? h->entries[i+1].day - 1 : end;
-        if(e > end) e = end;
-        if(s <= e) total += (e - s + 1) * (ll)h->entries[i].cost;
-        cur = e + 1;
-        i++;
-    }
-    return total;
-}
-
-/* Assignment Set Handling (Removing mirror duplicates s1-e1 vs s2-e2) */
+    const CostEntry *e = A->data + h->off;
+    return (ll)(cost_before(e, h->count, end + 1) - cost_before(e, h->count, start));
+}
+
+/*
+ * Assignment Set Handling. Every split is met twice by the search: as the
+ * arc starting at s1 and as its mirror starting at s2 = e1 + 1. Only the
+ * first of the two (smaller start) is stored, see find_best.
+ */
 static void init_assignments(AssignmentList *L){ L->items = NULL; L->count = L->capacity = 0; }
 static void free_assignments(AssignmentList *L){ free(L->items); }
 static void clear_assignments(AssignmentList *L){ L->count = 0; }
 
-static void normalize(int *s1, int *e1, int *s2, int *e2, int n){
-    int len1 = (*e1 >= *s1) ? (*e1 - *s1 + 1) : (n - *s1 + *e1 + 1);
-    int len2 = (*e2 >= *s2) ? (*e2 - *s2 + 1) : (n - *s2 + *e2 + 1);
-    if (len1 > len2 || (len1 == len2 && *s1 > *s2)) {
-        int ts = *s1, te = *e1;
-        *s1 = *s2; *e1 = *e2;
-        *s2 = ts;  *e2 = te;
-    }
-}
-
-static int duplicate(const AssignmentList *L, int s1, int e1, int s2, int e2, int n){
-    int ns1=s1, ne1=e1, ns2=s2, ne2=e2;
-    normalize(&ns1,&ne1,&ns2,&ne2,n);
-    for(size_t i=0; i<L->count; i++){
-        int cs1=L->items[i].s1, ce1=L->items[i].e1, cs2=L->items[i].s2, ce2=L->items[i].e2;
-        normalize(&cs1,&ce1,&cs2,&ce2,n);
-        if(ns1==cs1 && ne1==ce1 && ns2==cs2 && ne2==ce2) return 1;
-    }
-    return 0;
-}
-
-static void add_assignment(AssignmentList *L, int s1, int e1, int s2, int e2, int n){
-    if(duplicate(L, s1, e1, s2, e2, n)) return;
+static void add_assignment(AssignmentList *L, int s1, int e1, int s2, int e2){
     if(L->count==L->capacity){
         size_t nc = L->capacity ? L->capacity*2 : 8;
         L->items = (Assignment*)safe_realloc(L->items, nc * sizeof(Assignment));
@@ -130,35 +283,42 @@ static void add_assignment(AssignmentList *L, int s1, int e1, int s2, int e2, in
 /**
  * Finds the most balanced split of road sections between two companies.
  * Uses a prefix sum approach on a doubled array to handle circularity.
+ * All costs are positive, so for a fixed start the first company's sum grows
+ * with end and only the two ends around total/2 can be optimal. The first
+ * end reaching total/2 never moves back when start advances (two pointers),
+ * so the whole search is O(n) and visits candidates in the original order.
+ * Returns the smallest difference; the tied splits are left in res.
  */
-static void find_best(const ll *c, int n, AssignmentList *res){
-    ll total = 0;
-    for(int i=0; i<n; i++) total += c[i];
-    ll *pref = (ll*)safe_malloc((2*n+1) * sizeof(ll));
-    pref[0] = 0;
-    for(int i=0; i<2*n; i++) pref[i+1] = pref[i] + c[i % n];
-
+static ll find_best(const ll *pref, int n, AssignmentList *res){
+    ll total = pref[n];
     clear_assignments(res);
     ll best = -1;
+    int h = 0;
     for(int start=0; start<n; start++){
-        for(int end = start; end < start + n - 1; end++){
+        if(h < start) h = start;
+        while(h < start + n - 1 && 2*(pref[h+1] - pref[start]) < total) h++;
+        for(int end = h - 1; end <= h; end++){
+            if(end < start || end > start + n - 2) continue;
             ll a_sum = pref[end+1] - pref[start];
             ll b_sum = total - a_sum;
             ll diff = (a_sum >= b_sum) ? a_sum - b_sum : b_sum - a_sum;
+            /* The mirror split starts at (end+1)%n; if that is smaller it was already recorded */
             if(best < 0 || diff < best){
                 best = diff;
                 clear_assignments(res);
-                add_assignment(res, start%n, end%n, (end+1)%n, (start-1+n)%n, n);
+                if((end+1)%n > start) add_assignment(res, start%n, end%n, (end+1)%n, (start-1+n)%n);
             } else if(diff == best){
-                add_assignment(res, start%n, end%n, (end+1)%n, (start-1+n)%n, n);
+                if((end+1)%n > start) add_assignment(res, start%n, end%n, (end+1)%n, (start-1+n)%n);
             }
         }
     }
-    free(pref);
-    if(best < 0) best = 0;
+    return best < 0 ? 0 : best;
+}
+
+static void print_best(ll best, const AssignmentList *res){
     printf("Difference: %lld, options: %zu\n", best, res->count);
     for(size_t i=0; i<res->count; i++){
-        Assignment *a = &res->items[i];
+        const Assignment *a = &res->items[i];
         printf("* %d - %d, %d - %d\n", a->s1, a->e1, a->s2, a->e2);
     }
     /* Mandatory attribution required by problem specification */
@@ -166,83 +326,389 @@ static void find_best(const ll *c, int n, AssignmentList *res){
     fflush(stdout);
 }
 
-int main(void){
+/*
+ * k-Company Split. Parametric search over the cost bound U: with U fixed,
+ * nxt[i] is the farthest end of an arc of cost <= U starting at i (two
+ * pointers on the doubled prefix array), and U is feasible if from some
+ * start k jumps cover the whole ring. Binary search gives the smallest
+ * feasible U, i.e. the optimal largest arc. Under that bound every start
+ * then gets a balanced partition (each cut as close as possible to an even
+ * share of the rest, as long as the rest still fits into the remaining arcs)
+ * and the start with the smallest max - min spread wins. Only the largest
+ * arc is optimal, so that is the number reported; the spread printed next
+ * to it is the one of the chosen split, not a proven minimum.
+ */
+#define MAX_COMPANIES 8
+
+static void build_next(const ll *pref, int n, ll U, int *nxt){
+    int j = 0;
+    for(int i=0; i<2*n; i++){
+        if(j < i) j = i;
+        while(j < 2*n && pref[j+1] - pref[i] <= U) j++;
+        nxt[i] = j;
+    }
+}
+
+/* Can [pos, end) be cut into exactly r non-empty arcs of cost <= U? */
+static int fits(const int *nxt, int pos, int end, int r){
+    if(end - pos < r) return 0;
+    while(r-- > 0 && pos < end) pos = nxt[pos];
+    return pos >= end;
+}
+
+static int feasible(const ll *pref, int n, int k, ll U, int *nxt){
+    build_next(pref, n, U, nxt);
+    for(int s=0; s<n; s++) if(fits(nxt, s, s + n, k)) return 1;
+    return 0;
+}
+
+/* Balanced cuts from start s under bound U; returns the spread, cuts in cut[0..k] */
+static ll balanced_cuts(const ll *pref, const int *nxt, int n, int k, int s, int *cut){
+    int pos = s, end = s + n;
+    ll hi = 0, lo = -1;
+    cut[0] = s;
+    for(int j=0; j<k; j++){
+        int r = k - j, e;
+        if(r == 1) e = end;
+        else {
+            long double target = pref[pos] + (long double)(pref[end] - pref[pos]) / r;
+            int lo_e = pos + 1, hi_e = end - (r - 1);
+            /* first e in [lo_e, hi_e] with pref[e] >= target */
+            int L = lo_e, H = hi_e;
+            while(L < H){ int m = L + (H - L) / 2; if(pref[m] < target) L = m + 1; else H = m; }
+            e = -1;
+            long double best_gap = 0;
+            for(int c = L - 1; c <= L; c++){
+                if(c < lo_e || c > hi_e || c > nxt[pos] || !fits(nxt, c, end, r - 1)) continue;
+                long double gap = pref[c] - target; if(gap < 0) gap = -gap;
+                if(e < 0 || gap < best_gap){ e = c; best_gap = gap; }
+            }
+            if(e < 0){ e = nxt[pos]; if(e > hi_e) e = hi_e; }
+        }
+        ll sum = pref[e] - pref[pos];
+        if(sum > hi) hi = sum;
+        if(lo < 0 || sum < lo) lo = sum;
+        cut[j+1] = pos = e;
+    }
+    return hi - lo;
+}
+
+static void find_best_k(const ll *pref, int n, int k){
+    int *nxt = (int*)safe_malloc(2 * n * sizeof(int));
+    ll lo = 0, hi = pref[n];
+    for(int i=0; i<n; i++) if(pref[i+1] - pref[i] > lo) lo = pref[i+1] - pref[i];
+    while(lo < hi){
+        ll mid = lo + (hi - lo) / 2;
+        if(feasible(pref, n, k, mid, nxt)) hi = mid; else lo = mid + 1;
+    }
+    build_next(pref, n, lo, nxt);
+
+    int cut[MAX_COMPANIES + 1], best_cut[MAX_COMPANIES + 1];
+    ll best = -1;
+    for(int s=0; s<n; s++){
+        if(!fits(nxt, s, s + n, k)) continue;
+        ll spread = balanced_cuts(pref, nxt, n, k, s, cut);
+        if(best < 0 || spread < best){ best = spread; memcpy(best_cut, cut, sizeof(cut)); }
+    }
+    free(nxt);
+
+    printf("Largest arc: %lld, spread: %lld\n*", lo, best);
+    for(int j=0; j<k; j++)
+        printf("%s %d - %d", j ? "," : "", best_cut[j] % n, (best_cut[j+1] - 1) % n);
+    printf("\n");
+    /* Mandatory attribution required by problem specification */
+    printf("proudly generated with AI Assistant\n");
+    fflush(stdout);
+}
+
+/*
+ * Query Cache. Keeps the section totals, the doubled prefix array and the
+ * answer of the last queried interval. Updates are only remembered as a list
+ * of touched sections; when the same interval is asked again, just those
+ * sections are re-aggregated, their deltas patched into the prefix array,
+ * and the split search is re-run only if some total actually changed.
+ */
+typedef struct {
+    int valid, best_valid;       /* best_valid: best/res belong to the current totals */
+    ll a, b, best;
+    ll *costs, *pref;            /* n totals, 2n+1 prefix sums */
+    int *dirty; size_t ndirty;   /* sections updated since the last query */
+    unsigned char *is_dirty;
+} QueryCache;
+
+static void init_cache(QueryCache *q, size_t n){
+    q->valid = q->best_valid = 0; q->a = q->b = q->best = 0;
+    q->costs = (ll*)safe_malloc(n * sizeof(ll));
+    q->pref = (ll*)safe_malloc((2*n+1) * sizeof(ll));
+    q->dirty = (int*)safe_malloc(n * sizeof(int));
+    q->is_dirty = (unsigned char*)calloc(n, 1);
+    if(!q->is_dirty) exit(1);
+    q->ndirty = 0;
+}
+static void free_cache(QueryCache *q){ free(q->costs); free(q->pref); free(q->dirty); free(q->is_dirty); }
+
+/* An update on day `day` only moves totals of intervals that reach that day */
+static void mark_dirty(QueryCache *q, int idx, ll day){
+    if(!q->valid || day > q->b || q->is_dirty[idx]) return;
+    q->is_dirty[idx] = 1;
+    q->dirty[q->ndirty++] = idx;
+}
+
+static void rebuild_pref(QueryCache *q, int n, int from){
+    for(int i=from; i<2*n; i++) q->pref[i+1] = q->pref[i] + q->costs[i % n];
+}
+
+/*
+ * Worker Pool (-j). Persistent threads that each own a fixed chunk of the
+ * sections. A full rebuild runs in two phases: every worker aggregates its
+ * chunk and its chunk sum; the main thread scans the chunk sums into
+ * offsets; then every worker writes its part of the doubled prefix array.
+ * Chunks are fixed and sums are exact integers, so the result does not
+ * depend on the thread count.
+ */
+typedef struct WorkerPool WorkerPool;
+typedef struct { WorkerPool *pool; int id; } WorkerArg;
+
+struct WorkerPool {
+    int nthreads;
+    pthread_t *tid;
+    WorkerArg *args;
+    pthread_mutex_t mu;
+    pthread_cond_t go, done;
+    unsigned gen;
+    int phase, pending, quit;
+    /* current job */
+    const CostArena *arena;
+    QueryCache *q;
+    int n;
+    ll a, b;
+    ll *part;              /* per-chunk sum, then per-chunk offset */
+};
+
+static void pool_chunk(const WorkerPool *P, int id, int *lo, int *hi){
+    *lo = (int)((ll)P->n * id / P->nthreads);
+    *hi = (int)((ll)P->n * (id + 1) / P->nthreads);
+}
+
+static void* pool_worker(void *arg){
+    WorkerPool *P = ((WorkerArg*)arg)->pool;
+    int id = ((WorkerArg*)arg)->id;
+    unsigned seen = 0;
+    pthread_mutex_lock(&P->mu);
+    for(;;){
+        while(P->gen == seen && !P->quit) pthread_cond_wait(&P->go, &P->mu);
+        if(P->quit) break;
+        seen = P->gen;
+        int phase = P->phase;
+        pthread_mutex_unlock(&P->mu);
+
+        int lo, hi, n = P->n;
+        pool_chunk(P, id, &lo, &hi);
+        ll *costs = P->q->costs, *pref = P->q->pref;
+        if(phase == 0){
+            ll sum = 0;
+            for(int i=lo; i<hi; i++){ costs[i] = compute_total(P->arena, i, P->a, P->b); sum += costs[i]; }
+            P->part[id] = sum;
+        } else {
+            ll run = P->part[id], total = P->part[P->nthreads];
+            for(int i=lo; i<hi; i++){ run += costs[i]; pref[i+1] = run; pref[n+i+1] = total + run; }
+        }
+
+        pthread_mutex_lock(&P->mu);
+        if(--P->pending == 0) pthread_cond_signal(&P->done);
+    }
+    pthread_mutex_unlock(&P->mu);
+    return NULL;
+}
+
+static void pool_run(WorkerPool *P, int phase){
+    pthread_mutex_lock(&P->mu);
+    P->phase = phase;
+    P->pending = P->nthreads;
+    P->gen++;
+    pthread_cond_broadcast(&P->go);
+    while(P->pending > 0) pthread_cond_wait(&P->done, &P->mu);
+    pthread_mutex_unlock(&P->mu);
+}
+
+static void init_pool(WorkerPool *P, int nthreads){
+    P->nthreads = nthreads;
+    P->gen = 0; P->pending = 0; P->quit = 0; P->phase = 0;
+    P->part = (ll*)safe_malloc((nthreads + 1) * sizeof(ll));
+    P->tid = (pthread_t*)safe_malloc(nthreads * sizeof(pthread_t));
+    P->args = (WorkerArg*)safe_malloc(nthreads * sizeof(WorkerArg));
+    pthread_mutex_init(&P->mu, NULL);
+    pthread_cond_init(&P->go, NULL);
+    pthread_cond_init(&P->done, NULL);
+    for(int t=0; t<nthreads; t++){
+        P->args[t].pool = P; P->args[t].id = t;
+        if(pthread_create(&P->tid[t], NULL, pool_worker, &P->args[t]) != 0) exit(1);
+    }
+}
+
+static void free_pool(WorkerPool *P){
+    pthread_mutex_lock(&P->mu);
+    P->quit = 1;
+    pthread_cond_broadcast(&P->go);
+    pthread_mutex_unlock(&P->mu);
+    for(int t=0; t<P->nthreads; t++) pthread_join(P->tid[t], NULL);
+    pthread_mutex_destroy(&P->mu);
+    pthread_cond_destroy(&P->go);
+    pthread_cond_destroy(&P->done);
+    free(P->tid); free(P->part); free(P->args);
+}
+
+/* Totals and doubled prefix array of [a, b] for every section, on the pool */
+static void pool_aggregate(WorkerPool *P, const CostArena *A, QueryCache *q, int n, ll a, ll b){
+    P->arena = A; P->q = q; P->n = n; P->a = a; P->b = b;
+    pool_run(P, 0);
+    ll run = 0;
+    for(int t=0; t<P->nthreads; t++){ ll s = P->part[t]; P->part[t] = run; run += s; }
+    P->part[P->nthreads] = run;
+    q->pref[0] = 0;
+    pool_run(P, 1);
+}
+
+/* Brings the cached totals and prefix array up to date for [a, b]; returns 1 if they moved */
+static int refresh_totals(QueryCache *q, const CostArena *A, WorkerPool *pool, int n, ll a, ll b){
+    int lowest = n;
+    if(q->valid && q->a == a && q->b == b){
+        for(size_t k=0; k<q->ndirty; k++){
+            int i = q->dirty[k];
+            ll t = compute_total(A, i, a, b);
+            if(t != q->costs[i]){ q->costs[i] = t; if(i < lowest) lowest = i; }
+        }
+        if(lowest < n) rebuild_pref(q, n, lowest);
+    } else {
+        if(pool) pool_aggregate(pool, A, q, n, a, b);
+        else {
+            for(int i=0; i<n; i++) q->costs[i] = compute_total(A, i, a, b);
+            q->pref[0] = 0;
+            rebuild_pref(q, n, 0);
+        }
+        q->a = a; q->b = b; q->valid = 1;
+        lowest = 0;
+    }
+    for(size_t k=0; k<q->ndirty; k++) q->is_dirty[q->dirty[k]] = 0;
+    q->ndirty = 0;
+    return lowest < n;
+}
+
+static void answer_query(QueryCache *q, const CostArena *A, WorkerPool *pool, int n, ll a, ll b, int k, AssignmentList *res){
+    if(refresh_totals(q, A, pool, n, a, b)) q->best_valid = 0;
+    if(k > 2){ find_best_k(q->pref, n, k); return; }
+    if(!q->best_valid){
+        q->best = find_best(q->pref, n, res);
+        q->best_valid = 1;
+    }
+    print_best(q->best, res);
+}
+
+/* Number of worker threads for -j: explicit argument or all online CPUs */
+static int thread_count(int argc, char *argv[], int pos){
+    if(argc > pos){
+        int t = atoi(argv[pos]);
+        if(t > 0) return t;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+int main(int argc, char *argv[]){
+    int nthreads = (argc > 1 && strcmp(argv[1], "-j") == 0) ? thread_count(argc, argv, 2) : 1;
+
     printf("Daily cost:\n");
     fflush(stdout);
 
+    Reader rd; init_reader(&rd);
     int ch;
-    do { ch = fgetc(stdin); } while(ch != EOF && isspace(ch));
-    if (ch != '{') { printf("Invalid input.\n"); return 0; }
+    do { ch = reader_getc(&rd); } while(ch != EOF && is_space(ch));
+    if (ch != '{') { printf("Invalid input.\n"); free_reader(&rd); return 0; }
 
     size_t capacity = 64, n = 0;
     int *initial = (int*)safe_malloc(capacity * sizeof(int));
     int expecting_number = 1, seen_number = 0;
 
     /* Parse initial curly-brace cost list */
-    while((ch = fgetc(stdin)) != EOF){
-        if(isspace(ch)) continue;
+    while((ch = reader_getc(&rd)) != EOF){
+        if(is_space(ch)) continue;
         if(ch == '}') break;
         if(expecting_number){
-            if(!isdigit(ch)){ printf("Invalid input.\n"); free(initial); return 0; }
+            if(!is_digit(ch)){ printf("Invalid input.\n"); free(initial); free_reader(&rd); return 0; }
             long long v = ch - '0';
-            while((ch = fgetc(stdin)) != EOF && isdigit(ch)) v = v*10 + (ch - '0');
-            if(v <= 0 || v > INT_MAX){ printf("Invalid input.\n"); free(initial); return 0; }
+            while((ch = reader_getc(&rd)) != EOF && is_digit(ch)) v = v*10 + (ch - '0');
+            if(v <= 0 || v > INT_MAX){ printf("Invalid input.\n"); free(initial); free_reader(&rd); return 0; }
             if(n == capacity){ capacity *= 2; initial = (int*)safe_realloc(initial, capacity * sizeof(int)); }
             initial[n++] = (int)v;
             seen_number = 1;
             if(ch == ',') expecting_number = 1;
             else if(ch == '}') break;
-            else if(isspace(ch)) expecting_number = 0;
-            else { printf("Invalid input.\n"); free(initial); return 0; }
+            else if(is_space(ch)) expecting_number = 0;
+            else { printf("Invalid input.\n"); free(initial); free_reader(&rd); return 0; }
         } else if(ch == ',') expecting_number = 1;
-        else { printf("Invalid input.\n"); free(initial); return 0; }
+        else { printf("Invalid input.\n"); free(initial); free_reader(&rd); return 0; }
     }
 
-    if(!seen_number || n < 2 || n > 10000){ printf("Invalid input.\n"); free(initial); return 0; }
+    if(!seen_number || n < 2 || n > 10000){ printf("Invalid input.\n"); free(initial); free_reader(&rd); return 0; }
 
-    CostHistory *hist = (CostHistory*)safe_malloc(n * sizeof(CostHistory));
-    for(size_t i=0; i<n; i++){ init_history(&hist[i]); add_cost(&hist[i], 0, initial[i]); }
+    CostArena arena; init_arena(&arena, n);
+    for(size_t i=0; i<n; i++) add_cost(&arena, i, 0, initial[i]);
     free(initial);
 
     AssignmentList solutions; init_assignments(&solutions);
+    QueryCache cache; init_cache(&cache, n);
+    /* More threads than sections would only leave workers with empty chunks */
+    if((size_t)nthreads > n) nthreads = (int)n;
+    WorkerPool pool, *pp = NULL;
+    if(nthreads > 1){ init_pool(&pool, nthreads); pp = &pool; }
     ll last_update_day = -1;
 
-    char line[4096];
-    while(fgets(line, sizeof(line), stdin)){
+    char *line;
+    while((line = reader_line(&rd)) != NULL){
         const char *p = skipws(line);
         if(!*p) continue;
         if(*p == '='){ /* Cost Update Command */
-            p++; Date d; const char *after = parse_date(p, &d);
+            p++; Date d; const char *after = parse_date(p, &d, NULL);
             ll day;
             if(!after || !date_to_days(&d, &day) || (last_update_day >= 0 && day <= last_update_day))
                 { printf("Invalid input.\n"); goto cleanup; }
             last_update_day = day;
             p = skipws(after);
             long idx = 0; const char *sstart = p;
-            while(isdigit((unsigned char)*p)){ idx = idx*10 + (*p - '0'); p++; }
+            while(is_digit((unsigned char)*p)){ idx = idx*10 + (*p - '0'); p++; }
             if(p == sstart || idx < 0 || idx >= (long)n || *skipws(p) != ':')
                 { printf("Invalid input.\n"); goto cleanup; }
             p = skipws(skipws(p)+1);
             long long cost = 0; const char *cstart = p;
-            while(isdigit((unsigned char)*p)){ cost = cost*10 + (*p - '0'); p++; }
+            while(is_digit((unsigned char)*p)){ cost = cost*10 + (*p - '0'); p++; }
             if(p == cstart || cost <= 0 || cost > INT_MAX) { printf("Invalid input.\n"); goto cleanup; }
-            add_cost(&hist[idx], day, (int)cost);
+            add_cost(&arena, (size_t)idx, day, (int)cost);
+            mark_dirty(&cache, (int)idx, day);
         } else if(*p == '?'){ /* Query Assignment Command */
             p++; Date d1, d2; ll a, b;
-            const char *after1 = parse_date(p, &d1);
+            const char *after1 = parse_date(p, &d1, NULL);
             if(!after1 || !date_to_days(&d1, &a)) { printf("Invalid input.\n"); goto cleanup; }
-            const char *after2 = parse_date(skipws(after1), &d2);
+            const char *scanned2, *after2 = parse_date(skipws(after1), &d2, &scanned2);
             if(!after2 || !date_to_days(&d2, &b) || a > b) { printf("Invalid input.\n"); goto cleanup; }
-            ll *costs = (ll*)safe_malloc(n * sizeof(ll));
-            for(size_t i=0; i<n; i++) costs[i] = compute_total(&hist[i], a, b);
-            find_best(costs, (int)n, &solutions);
-            free(costs);
+            /* Optional number of companies (a lone trailing number), two by default */
+            long k = 2;
+            p = skipws(scanned2 > after2 ? scanned2 : after2);
+            const char *kstart = p;
+            while(is_digit((unsigned char)*p)) p++;
+            if(p != kstart && !*skipws(p)){
+                k = 0;
+                for(const char *q = kstart; q < p && k <= MAX_COMPANIES; q++) k = k*10 + (*q - '0');
+                if(k < 2 || k > MAX_COMPANIES || k > (long)n) { printf("Invalid input.\n"); goto cleanup; }
+            }
+            answer_query(&cache, &arena, pp, (int)n, a, b, (int)k, &solutions);
         } else { printf("Invalid input.\n"); goto cleanup; }
     }
 
 cleanup:
+    free_cache(&cache);
     free_assignments(&solutions);
-    for(size_t i=0; i<n; i++) free_history(&hist[i]);
-    free(hist);
+    if(pp) free_pool(pp);
+    free_arena(&arena);
+    free_reader(&rd);
     return 0;
 }
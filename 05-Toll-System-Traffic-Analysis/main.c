@@ -1,7 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
 
 /* -------------------- CONSTANTS -------------------- */
 
@@ -11,8 +14,8 @@
 /* Number of months in a year */
 #define MONTHS 12
 
-/* Initial buffer size for reading input */
-#define INITIAL_BUF_SIZE 65536
+/* Size of one input chunk; input is streamed, never buffered whole */
+#define CHUNK_SIZE 65536
 
 /* -------------------- MONTH DATA -------------------- */
 
@@ -34,23 +37,27 @@ typedef struct {
     int m, d, h, n;
 } Tick;
 
-/* One camera record: camera ID + timestamp */
-typedef struct {
-    int camid;
-    Tick t;
-} Peep;
+/*
+ * One camera record packed into a single key: minute of the year in the
+ * high 32 bits, camera ID (sign bit flipped, so signed order is kept) in
+ * the low 32 bits. Keys sort chronologically, and by camera within a minute.
+ */
+typedef unsigned long long Peep;
 
-/* One car: license plate + dynamic array of camera records */
+/* One car: license plate (+ its hash) + dynamic array of camera records */
 typedef struct {
     char *rz;
+    unsigned long long hash;
     Peep *peeps;
     size_t n, cap;
 } Car;
 
-/* Whole toll system: dynamic array of cars */
+/* Whole toll system: dynamic array of cars + hash index over their plates */
 typedef struct {
     Car *cars;
     size_t n, cap;
+    size_t *slots;      /* open addressing: car index + 1, 0 = empty */
+    size_t nslots;      /* power of two, kept at least twice the car count */
 } Toll;
 
 /* -------------------- SAFE MEMORY HELPERS -------------------- */
@@ -94,14 +101,36 @@ static int valid_tick(Tick t){
     return 1;
 }
 
-/* Compare two timestamps chronologically */
-static int tick_cmp(Tick a, Tick b){
-    if(a.m != b.m) return a.m - b.m;
-    if(a.d != b.d) return a.d - b.d;
-    if(a.h != b.h) return a.h - b.h;
-    return a.n - b.n;
+/* Minute of the year of a valid timestamp */
+static unsigned tick_to_min(Tick t){
+    unsigned day = (unsigned)t.d - 1;
+    for(int i = 0; i < t.m - 1; i++)
+        day += (unsigned)month_days[i];
+    return (day * 24 + (unsigned)t.h) * 60 + (unsigned)t.n;
+}
+
+/* Timestamp of a minute of the year */
+static Tick min_to_tick(unsigned min){
+    Tick t;
+    unsigned day = min / (24 * 60);
+    t.n = (int)(min % 60);
+    t.h = (int)(min / 60 % 24);
+    t.m = 1;
+    while(day >= (unsigned)month_days[t.m - 1]){
+        day -= (unsigned)month_days[t.m - 1];
+        t.m++;
+    }
+    t.d = (int)day + 1;
+    return t;
 }
 
+/* Pack / unpack a camera record key */
+static Peep make_peep(int camid, Tick t){
+    return ((Peep)tick_to_min(t) << 32) | ((unsigned)camid ^ 0x80000000u);
+}
+static unsigned peep_min(Peep p){ return (unsigned)(p >> 32); }
+static int peep_camid(Peep p){ return (int)((unsigned)p ^ 0x80000000u); }
+
 /* -------------------- STRING HELPERS -------------------- */
 
 /* Custom strdup using xmalloc */
@@ -113,14 +142,48 @@ static char *my_strdup(const char *s){
 
 /* -------------------- CAR MANAGEMENT -------------------- */
 
-/* Find a car by license plate */
+/* FNV-1a hash of a license plate */
+static unsigned long long hash_rz(const char *s){
+    unsigned long long h = 1469598103934665603ULL;
+    while(*s){
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Find a car by license plate (linear probing in the hash index) */
 static Car *find_car(Toll *t, const char *rz){
-    for(size_t i = 0; i < t->n; i++)
-        if(strcmp(t->cars[i].rz, rz) == 0)
-            return &t->cars[i];
+    if(t->nslots == 0) return NULL;
+    unsigned long long h = hash_rz(rz);
+    size_t mask = t->nslots - 1;
+    for(size_t i = (size_t)h & mask; t->slots[i]; i = (i + 1) & mask){
+        Car *c = &t->cars[t->slots[i] - 1];
+        if(c->hash == h && strcmp(c->rz, rz) == 0)
+            return c;
+    }
     return NULL;
 }
 
+/* Put car number idx into the index (its plate is known to be absent) */
+static void index_car(Toll *t, size_t idx){
+    size_t mask = t->nslots - 1;
+    size_t i = (size_t)t->cars[idx].hash & mask;
+    while(t->slots[i]) i = (i + 1) & mask;
+    t->slots[i] = idx + 1;
+}
+
+/* Double the index and re-insert all cars using their stored hashes */
+static void grow_index(Toll *t){
+    size_t newslots = t->nslots ? t->nslots * 2 : 16;
+    free(t->slots);
+    t->slots = (size_t*)xmalloc(sizeof(size_t) * newslots);
+    memset(t->slots, 0, sizeof(size_t) * newslots);
+    t->nslots = newslots;
+    for(size_t i = 0; i < t->n; i++)
+        index_car(t, i);
+}
+
 /* Add a new car to the toll system */
 static Car *add_car(Toll *t, const char *rz){
     if(t->n == t->cap){
@@ -130,9 +193,12 @@ static Car *add_car(Toll *t, const char *rz){
     }
     Car *c = &t->cars[t->n++];
     c->rz = my_strdup(rz);
+    c->hash = hash_rz(rz);
     c->peeps = NULL;
     c->n = 0;
     c->cap = 0;
+    if(2 * t->n > t->nslots) grow_index(t);
+    else index_car(t, t->n - 1);
     return c;
 }
 
@@ -143,47 +209,116 @@ static void add_peep(Car *c, int camid, Tick tt){
         c->peeps = (Peep*)xrealloc(c->peeps, sizeof(Peep) * newcap);
         c->cap = newcap;
     }
-    c->peeps[c->n].camid = camid;
-    c->peeps[c->n].t = tt;
-    c->n++;
+    c->peeps[c->n++] = make_peep(camid, tt);
+}
+
+/* Straight insertion sort, used for short histories */
+static void insertion_sort(Peep *a, size_t n){
+    for(size_t i = 1; i < n; i++){
+        Peep v = a[i];
+        size_t j = i;
+        while(j > 0 && a[j - 1] > v){
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = v;
+    }
 }
 
-/* Comparator for qsort (by timestamp) */
-static int peep_cmp(const void *a, const void *b){
-    const Peep *pa = (const Peep*)a;
-    const Peep *pb = (const Peep*)b;
-    return tick_cmp(pa->t, pb->t);
+/*
+ * LSD radix sort on the 64-bit keys, one byte per pass. Passes where every
+ * key has the same byte (e.g. the unused top bits of the minute) are
+ * skipped. tmp must hold n keys.
+ */
+static void radix_sort(Peep *a, size_t n, Peep *tmp){
+    if(n < 64){
+        insertion_sort(a, n);
+        return;
+    }
+    Peep *src = a, *dst = tmp;
+    for(int shift = 0; shift < 64; shift += 8){
+        size_t count[256] = {0};
+        for(size_t i = 0; i < n; i++)
+            count[(src[i] >> shift) & 0xFF]++;
+        if(count[(src[0] >> shift) & 0xFF] == n) continue;
+
+        size_t pos = 0;
+        for(int b = 0; b < 256; b++){
+            size_t c = count[b];
+            count[b] = pos;
+            pos += c;
+        }
+        for(size_t i = 0; i < n; i++)
+            dst[count[(src[i] >> shift) & 0xFF]++] = src[i];
+        Peep *sw = src; src = dst; dst = sw;
+    }
+    if(src != a) memcpy(a, src, n * sizeof(Peep));
 }
 
 /* Sort all camera records for each car */
 static void sort_all_peeps(Toll *t){
-    for(size_t i = 0; i < t->n; i++){
-        if(t->cars[i].n > 0){
-            qsort(t->cars[i].peeps,
-                  t->cars[i].n,
-                  sizeof(Peep),
-                  peep_cmp);
-        }
+    size_t maxn = 0;
+    for(size_t i = 0; i < t->n; i++)
+        if(t->cars[i].n > maxn) maxn = t->cars[i].n;
+    if(maxn < 64) maxn = 0;
+
+    Peep *tmp = maxn ? (Peep*)xmalloc(sizeof(Peep) * maxn) : NULL;
+    for(size_t i = 0; i < t->n; i++)
+        radix_sort(t->cars[i].peeps, t->cars[i].n, tmp);
+    free(tmp);
+}
+
+/* -------------------- STREAMING INPUT -------------------- */
+
+/*
+ * Chunked reader over stdin. Parsers look at one character at a time, so
+ * tokens split across chunk boundaries need no special care. The report
+ * list ends, as it always has, with the line that holds the first '}':
+ * past that line the report parser sees end of input, and the search
+ * queries start on the following line.
+ */
+typedef struct {
+    char buf[CHUNK_SIZE];
+    size_t pos, len;
+    int eof;
+    int brace_seen;     /* a '}' has been consumed */
+    int reports_end;    /* the line with the first '}' is finished */
+    int queries;        /* reading queries: ignore the report limit */
+} Reader;
+
+/* Next character without consuming it, EOF at the end */
+static int rd_peek(Reader *rd){
+    if(rd->reports_end && !rd->queries) return EOF;
+    if(rd->pos == rd->len){
+        if(rd->eof) return EOF;
+        ssize_t got;
+        do got = read(STDIN_FILENO, rd->buf, CHUNK_SIZE); while(got < 0 && errno == EINTR);
+        if(got <= 0){ rd->eof = 1; return EOF; }
+        rd->pos = 0;
+        rd->len = (size_t)got;
     }
+    return (unsigned char)rd->buf[rd->pos];
+}
+
+/* Consume the character returned by rd_peek */
+static void rd_next(Reader *rd){
+    char c = rd->buf[rd->pos++];
+    if(c == '}') rd->brace_seen = 1;
+    else if(c == '\n' && rd->brace_seen) rd->reports_end = 1;
 }
 
-/* Simple integer sort (ascending) */
-static void sort_ints(int *a, size_t n){
-    for(size_t i = 0; i < n; i++)
-        for(size_t j = i + 1; j < n; j++)
-            if(a[i] > a[j]){
-                int tmp = a[i];
-                a[i] = a[j];
-                a[j] = tmp;
-            }
+/* Switch to the search queries: drop the rest of the closing report line */
+static void rd_start_queries(Reader *rd){
+    while(rd_peek(rd) != EOF) rd_next(rd);
+    rd->queries = 1;
 }
 
 /* -------------------- PARSING HELPERS -------------------- */
 
 /* Skip whitespace */
-static void skip_spaces(char **p){
-    while(**p && isspace((unsigned char)**p))
-        (*p)++;
+static void skip_spaces(Reader *rd){
+    while(isspace(rd_peek(rd)))
+        rd_next(rd);
 }
 
 /* Parse a full integer string strictly */
@@ -204,23 +339,23 @@ static void free_all(Toll *t){
         free(t->cars[i].peeps);
     }
     free(t->cars);
+    free(t->slots);
     t->cars = NULL;
-    t->n = t->cap = 0;
+    t->slots = NULL;
+    t->n = t->cap = t->nslots = 0;
 }
 
-/* Parse unsigned integer directly from buffer */
-static int parse_uint_strict(char **pp, int *out){
-    char *p = *pp;
-    if(!isdigit((unsigned char)*p)) return 0;
+/* Parse unsigned integer directly from the input */
+static int parse_uint_strict(Reader *rd, int *out){
+    if(!isdigit(rd_peek(rd))) return 0;
     long val = 0;
     int digits = 0;
-    while(*p && isdigit((unsigned char)*p)){
-        val = val * 10 + (*p - '0');
-        p++;
+    while(isdigit(rd_peek(rd))){
+        val = val * 10 + (rd_peek(rd) - '0');
+        rd_next(rd);
         digits++;
         if(digits > 10) return 0;
     }
-    *pp = p;
     *out = (int)val;
     return 1;
 }
@@ -228,39 +363,74 @@ static int parse_uint_strict(char **pp, int *out){
 /* -------------------- TOKEN & SEARCH HELPERS -------------------- */
 
 /* Read one whitespace-separated token */
-static int parse_token(char **pp, char *buf, size_t bufsz){
-    char *p = *pp;
-    if(!*p || isspace((unsigned char)*p)) return 0;
+static int parse_token(Reader *rd, char *buf, size_t bufsz){
+    int c = rd_peek(rd);
+    if(c == EOF || isspace(c)) return 0;
     size_t i = 0;
-    while(*p && !isspace((unsigned char)*p)){
-        if(i + 1 < bufsz) buf[i++] = *p;
+    while((c = rd_peek(rd)) != EOF && !isspace(c)){
+        if(i + 1 < bufsz) buf[i++] = (char)c;
         else return 0;
-        p++;
+        rd_next(rd);
     }
     buf[i] = '\0';
-    *pp = p;
     return 1;
 }
 
-/* Binary search: first >= target */
-static size_t lower_bound(Peep *arr, size_t n, Tick target){
-    size_t left = 0, right = n;
-    while(left < right){
-        size_t mid = left + (right - left) / 2;
-        if(tick_cmp(arr[mid].t, target) < 0)
-            left = mid + 1;
-        else
-            right = mid;
+/* scanf "%<width>s": skip whitespace, read up to width non-space characters */
+static int scan_string(Reader *rd, char *buf, size_t width){
+    skip_spaces(rd);
+    int c = rd_peek(rd);
+    if(c == EOF) return 0;
+    size_t i = 0;
+    while(i < width && (c = rd_peek(rd)) != EOF && !isspace(c)){
+        buf[i++] = (char)c;
+        rd_next(rd);
     }
-    return left;
+    buf[i] = '\0';
+    return 1;
+}
+
+/* scanf "%d": skip whitespace, optional sign, digits (converted like strtol, then narrowed) */
+static int scan_int(Reader *rd, int *out){
+    skip_spaces(rd);
+    int neg = 0;
+    if(rd_peek(rd) == '+' || rd_peek(rd) == '-'){
+        neg = (rd_peek(rd) == '-');
+        rd_next(rd);
+    }
+    if(!isdigit(rd_peek(rd))) return 0;
+    unsigned long val = 0;
+    int over = 0;
+    while(isdigit(rd_peek(rd))){
+        unsigned d = (unsigned)(rd_peek(rd) - '0');
+        if(val > ((unsigned long)LONG_MAX - d) / 10) over = 1;
+        else val = val * 10 + d;
+        rd_next(rd);
+    }
+    long v = over ? (neg ? LONG_MIN : LONG_MAX) : (neg ? -(long)val : (long)val);
+    *out = (int)v;
+    return 1;
+}
+
+/* One search query, read like scanf("%1001s %3s %d %d:%d"); returns the number of fields or EOF */
+static int read_query(Reader *rd, char *rz, char *mon, int *d, int *h, int *m){
+    if(!scan_string(rd, rz, MAX_RZ + 1)) return EOF;
+    if(!scan_string(rd, mon, 3)) return 1;
+    if(!scan_int(rd, d)) return 2;
+    if(!scan_int(rd, h)) return 3;
+    if(rd_peek(rd) != ':') return 4;
+    rd_next(rd);
+    if(!scan_int(rd, m)) return 4;
+    return 5;
 }
 
-/* Binary search: first > target */
-static size_t upper_bound(Peep *arr, size_t n, Tick target){
+/* Binary search: first record at or after minute target */
+static size_t lower_bound(const Peep *arr, size_t n, unsigned target){
+    Peep key = (Peep)target << 32;
     size_t left = 0, right = n;
     while(left < right){
         size_t mid = left + (right - left) / 2;
-        if(tick_cmp(arr[mid].t, target) <= 0)
+        if(arr[mid] < key)
             left = mid + 1;
         else
             right = mid;
@@ -268,93 +438,64 @@ static size_t upper_bound(Peep *arr, size_t n, Tick target){
     return left;
 }
 
+/* Binary search: first record after minute target */
+static size_t upper_bound(const Peep *arr, size_t n, unsigned target){
+    return lower_bound(arr, n, target + 1);
+}
+
 /* -------------------- SEARCH LOGIC -------------------- */
 
-/* Search for exact, previous, and next sightings */
+/*
+ * Print one block of same-minute sightings. Keys are ordered by time and
+ * then by camera, so the IDs come out sorted without any copying.
+ */
+static void print_block(const char *label, const Peep *p, size_t cnt){
+    Tick t = min_to_tick(peep_min(p[0]));
+    printf("> %s: %s %d %02d:%02d, %zux [",
+           label, months[t.m - 1], t.d, t.h, t.n, cnt);
+    for(size_t i = 0; i < cnt; i++){
+        if(i) printf(", ");
+        printf("%d", peep_camid(p[i]));
+    }
+    printf("]\n");
+}
+
+/*
+ * Search for exact, previous, and next sightings. Binary search finds the
+ * block of the query minute; when it is empty, the previous and next blocks
+ * border its position and are found by walking over the records that get
+ * printed anyway: O(log n + output), no allocation.
+ */
 static void search_car(Car *c, Tick t){
-    size_t start = lower_bound(c->peeps, c->n, t);
-    size_t end = upper_bound(c->peeps, c->n, t);
-    size_t nmatch = end - start;
+    unsigned tm = tick_to_min(t);
+    const Peep *peeps = c->peeps;
+    size_t start = lower_bound(peeps, c->n, tm);
+    size_t end = upper_bound(peeps, c->n, tm);
 
     /* Exact match found */
-    if(nmatch > 0){
-        int *ids = (int*)xmalloc(sizeof(int) * nmatch);
-        for(size_t i = 0; i < nmatch; i++)
-            ids[i] = c->peeps[start + i].camid;
-
-        sort_ints(ids, nmatch);
-
-        printf("> Exact: %s %d %02d:%02d, %zux [",
-               months[t.m - 1], t.d, t.h, t.n, nmatch);
-
-        for(size_t i = 0; i < nmatch; i++){
-            if(i) printf(", ");
-            printf("%d", ids[i]);
-        }
-        printf("]\n");
-        free(ids);
+    if(end > start){
+        print_block("Exact", peeps + start, end - start);
         return;
     }
 
-    /* Handle previous and next sightings */
-    int has_prev = 0, has_next = 0;
-    Tick prev = {0,0,0,0}, next = {0,0,0,0};
-
-    if(start > 0){
-        has_prev = 1;
-        prev = c->peeps[start - 1].t;
-    }
-    if(start < c->n){
-        has_next = 1;
-        next = c->peeps[start].t;
-    }
-
     /* Previous */
-    if(has_prev){
-        size_t ps = lower_bound(c->peeps, c->n, prev);
-        size_t pe = upper_bound(c->peeps, c->n, prev);
-        size_t cnt = pe - ps;
-
-        int *ids = (int*)xmalloc(sizeof(int) * cnt);
-        for(size_t i = 0; i < cnt; i++)
-            ids[i] = c->peeps[ps + i].camid;
-
-        sort_ints(ids, cnt);
-
-        printf("> Previous: %s %d %02d:%02d, %zux [",
-               months[prev.m - 1], prev.d, prev.h, prev.n, cnt);
-
-        for(size_t i = 0; i < cnt; i++){
-            if(i) printf(", ");
-            printf("%d", ids[i]);
-        }
-        printf("]\n");
-        free(ids);
+    if(start > 0){
+        unsigned pm = peep_min(peeps[start - 1]);
+        size_t ps = start - 1;
+        while(ps > 0 && peep_min(peeps[ps - 1]) == pm)
+            ps--;
+        print_block("Previous", peeps + ps, start - ps);
     } else {
         printf("> Previous: N/A\n");
     }
 
     /* Next */
-    if(has_next){
-        size_t ns = lower_bound(c->peeps, c->n, next);
-        size_t ne = upper_bound(c->peeps, c->n, next);
-        size_t cnt = ne - ns;
-
-        int *ids = (int*)xmalloc(sizeof(int) * cnt);
-        for(size_t i = 0; i < cnt; i++)
-            ids[i] = c->peeps[ns + i].camid;
-
-        sort_ints(ids, cnt);
-
-        printf("> Next: %s %d %02d:%02d, %zux [",
-               months[next.m - 1], next.d, next.h, next.n, cnt);
-
-        for(size_t i = 0; i < cnt; i++){
-            if(i) printf(", ");
-            printf("%d", ids[i]);
-        }
-        printf("]\n");
-        free(ids);
+    if(start < c->n){
+        unsigned nm = peep_min(peeps[start]);
+        size_t ne = start + 1;
+        while(ne < c->n && peep_min(peeps[ne]) == nm)
+            ne++;
+        print_block("Next", peeps + start, ne - start);
     } else {
         printf("> Next: N/A\n");
     }
@@ -362,73 +503,72 @@ static void search_car(Car *c, Tick t){
 
 /* -------------------- MAIN INPUT PARSING -------------------- */
 
-/* Parse camera reports from input buffer */
-static int parse_reports(Toll *t, char *buf){
-    char *p = buf;
-    skip_spaces(&p);
+/* Parse camera reports straight from the input stream */
+static int parse_reports(Toll *t, Reader *rd){
+    skip_spaces(rd);
 
-    if(*p != '{') return 0;
-    p++;
-    skip_spaces(&p);
+    if(rd_peek(rd) != '{') return 0;
+    rd_next(rd);
+    skip_spaces(rd);
 
-    if(*p == '}') return 0;
+    if(rd_peek(rd) == '}') return 0;
 
-    while(*p){
-        skip_spaces(&p);
-        if(*p == '}'){ p++; break; }
+    while(rd_peek(rd) != EOF){
+        skip_spaces(rd);
+        if(rd_peek(rd) == '}'){ rd_next(rd); break; }
 
         /* Camera ID */
         char cambuf[64];
         int cb = 0;
 
-        if(!isdigit((unsigned char)*p)) return 0;
-        while(*p && isdigit((unsigned char)*p)){
+        if(!isdigit(rd_peek(rd))) return 0;
+        while(isdigit(rd_peek(rd))){
             if(cb < (int)sizeof(cambuf) - 1)
-                cambuf[cb++] = *p;
-            p++;
+                cambuf[cb++] = (char)rd_peek(rd);
+            rd_next(rd);
         }
         cambuf[cb] = '\0';
         if(cb == 0 || (cb > 1 && cambuf[0] == '0')) return 0;
 
-        skip_spaces(&p);
-        if(*p != ':') return 0;
-        p++;
-        skip_spaces(&p);
+        skip_spaces(rd);
+        if(rd_peek(rd) != ':') return 0;
+        rd_next(rd);
+        skip_spaces(rd);
 
         int camid;
         if(!parse_int_str(cambuf, &camid)) return 0;
 
         /* License plate */
         char rzbuf[MAX_RZ + 2];
-        if(!parse_token(&p, rzbuf, sizeof(rzbuf))) return 0;
+        if(!parse_token(rd, rzbuf, sizeof(rzbuf))) return 0;
         if(strlen(rzbuf) == 0 || strlen(rzbuf) > MAX_RZ) return 0;
 
         /* Month */
-        skip_spaces(&p);
+        skip_spaces(rd);
         char monbuf[8];
-        if(!parse_token(&p, monbuf, sizeof(monbuf))) return 0;
+        if(!parse_token(rd, monbuf, sizeof(monbuf))) return 0;
         if(strlen(monbuf) != 3 || month_to_int(monbuf) == -1) return 0;
 
         /* Day */
-        skip_spaces(&p);
+        skip_spaces(rd);
         int day;
-        if(!parse_uint_strict(&p, &day)) return 0;
+        if(!parse_uint_strict(rd, &day)) return 0;
 
         /* Hour */
-        skip_spaces(&p);
+        skip_spaces(rd);
         int hour;
-        if(!parse_uint_strict(&p, &hour)) return 0;
+        if(!parse_uint_strict(rd, &hour)) return 0;
 
         /* Minute */
-        skip_spaces(&p);
-        if(*p != ':') return 0;
-        p++;
-        skip_spaces(&p);
+        skip_spaces(rd);
+        if(rd_peek(rd) != ':') return 0;
+        rd_next(rd);
+        skip_spaces(rd);
         int minute;
-        if(!parse_uint_strict(&p, &minute)) return 0;
+        if(!parse_uint_strict(rd, &minute)) return 0;
 
-        skip_spaces(&p);
-        if(*p != ',' && *p != '}') return 0;
+        skip_spaces(rd);
+        if(rd_peek(rd) != ',' && rd_peek(rd) != '}') return 0;
 
         Tick tt = {
             month_to_int(monbuf),
@@ -442,8 +582,8 @@ static int parse_reports(Toll *t, char *buf){
         if(!c) c = add_car(t, rzbuf);
         add_peep(c, camid, tt);
 
-        if(*p == ',') p++;
-        else if(*p == '}'){ p++; break; }
+        if(rd_peek(rd) == ',') rd_next(rd);
+        else if(rd_peek(rd) == '}'){ rd_next(rd); break; }
         else return 0;
     }
     return 1;
@@ -452,42 +592,22 @@ static int parse_reports(Toll *t, char *buf){
 /* -------------------- MAIN -------------------- */
 
 int main(){
-    Toll t = { NULL, 0, 0 };
+    Toll t = { NULL, 0, 0, NULL, 0 };
 
-    /* Dynamic input buffer */
-    size_t bufsize = INITIAL_BUF_SIZE;
-    char *buf = (char*)xmalloc(bufsize);
-    size_t len = 0;
+    /* Chunked input, shared by the reports and the search queries */
+    Reader *rd = (Reader*)xmalloc(sizeof(Reader));
+    rd->pos = rd->len = 0;
+    rd->eof = rd->brace_seen = rd->reports_end = rd->queries = 0;
 
     printf("Camera reports:\n");
 
-    /* Read input until closing brace is found */
-    int found_brace = 0;
-    while(!found_brace){
-        if(len >= bufsize - 1024){
-            bufsize *= 2;
-            buf = (char*)xrealloc(buf, bufsize);
-        }
-
-        char *result = fgets(buf + len, (int)(bufsize - len), stdin);
-        if(!result) break;
-
-        size_t old_len = len;
-        len = strlen(buf);
-        for(size_t i = old_len; i < len; i++){
-            if(buf[i] == '}'){
-                found_brace = 1;
-                break;
-            }
-        }
-    }
-
-    if(len == 0 || !parse_reports(&t, buf)){
+    if(!parse_reports(&t, rd)){
         printf("Invalid input.\n");
         free_all(&t);
-        free(buf);
+        free(rd);
         return 0;
     }
+    rd_start_queries(rd);
 
     /* Sort all camera sightings */
     sort_all_peeps(&t);
@@ -500,7 +620,7 @@ int main(){
     int dq, hq, mq;
 
     while(1){
-        int r = scanf("%1001s %3s %d %d:%d", rzq, monq, &dq, &hq, &mq);
+        int r = read_query(rd, rzq, monq, &dq, &hq, &mq);
         if(r == EOF) break;
         if(r != 5){
             printf("Invalid input.\n");
@@ -527,6 +647,6 @@ int main(){
     }
 
     free_all(&t);
-    free(buf);
+    free(rd);
     return 0;
 }